@@ -4,11 +4,18 @@
 // 
 //  Scott Lawrence - yorgle@gmail.com
 //
+//  2026-Oct-19  v003  Added bin, binary block transfer with CRC
 //  2013-Mar-01  v002  Added Poke, smarter Print
 //  2013-Feb-18  v001  Initial basic version
 
 
-#include <EEPROM.h>
+#ifdef ARDUINO
+  #include <EEPROM.h>
+#else
+  // the desktop build, with the serial port on a pty (see cli/)
+  #include "eexsim.h"
+#endif
+#include "eeproto.h"
 
 // kLED - the pin that the indicator LED is connected to.
 #define kLED 13
@@ -33,7 +40,7 @@ void setup()
 void serialAbout( void )
 {
   Serial.println( "" );
-  Serial.println( "EEExplorer v002  Scott Lawrence  yorgle@gmail.com" );
+  Serial.println( "EEExplorer v003  Scott Lawrence  yorgle@gmail.com" );
   Serial.println( "" );
   Serial.print( " Flash size: " ); Serial.print( (unsigned) FLASHEND +1 ); Serial.println( " bytes" );
   Serial.print( "   RAM size: " ); Serial.print( RAMEND +1 ); Serial.println( " bytes" );
@@ -45,6 +52,7 @@ void serialAbout( void )
   Serial.println( " print     text dump of the EEProm" );
   Serial.println( " record    erase EEProm until '.', buffer fill or reset" );
   Serial.println( " poke A D  poke value D into address a (decimal values)" );
+  Serial.println( " bin       binary block mode, for the host tool (cli/eex)" );
 }
 
 
@@ -247,6 +255,140 @@ void pokeEE( char * buf )
   EEPROM.write( addr, data );  
 }
 
+// binary mode
+//   the block protocol described in eeproto.h.  The frame buffer holds
+//   the command being read, then the answer to it.
+unsigned char frame[ kEEFrame ];
+
+unsigned int frameAddr( void )
+{
+  return frame[1] | ( frame[2] << 8 );
+}
+
+// sendFrame
+//   add the CRC to the first n bytes of the frame buffer, and send them
+void sendFrame( int n )
+{
+  unsigned short crc = eeCrc( frame, n );
+  frame[n] = crc & 0x0ff;
+  frame[n+1] = crc >> 8;
+  Serial.write( frame, n + 2 );
+}
+
+// nakFrame
+//   drop what is left of a bad frame, until the line is quiet, and
+//   tell the host to send it again
+boolean nakFrame( unsigned char err )
+{
+  while( Serial.readBytes( (char *)frame, 1 ) == 1 );
+  frame[0] = EE_NAK;
+  frame[1] = err;
+  sendFrame( 2 );
+  return false;
+}
+
+// getFrame
+//   read the rest of the frame whose command is in frame[0], and
+//   check its CRC
+boolean getFrame( void )
+{
+  int n = 0;
+  
+  if( frame[0] != EE_QUIT ) {
+    n = 3;
+    if( Serial.readBytes( (char *)frame + 1, n ) != (size_t)n ) return nakFrame( EE_ERR_TIMEOUT );
+    if( frame[3] == 0 || frame[3] > kEEBlock || frameAddr() + frame[3] > E2END + 1 )
+      return nakFrame( EE_ERR_RANGE );
+    if( frame[0] == EE_WRITE ) {
+      if( Serial.readBytes( (char *)frame + 4, frame[3] ) != frame[3] ) return nakFrame( EE_ERR_TIMEOUT );
+      n += frame[3];
+    }
+  }
+  
+  if( Serial.readBytes( (char *)frame + 1 + n, 2 ) != 2 ) return nakFrame( EE_ERR_TIMEOUT );
+  if( eeCrc( frame, 1 + n ) != ( frame[1+n] | ( frame[2+n] << 8 )))
+    return nakFrame( EE_ERR_CRC );
+  return true;
+}
+
+// binaryEE
+//   answer block commands until the host quits, or goes away
+void binaryEE( void )
+{
+  unsigned long idle;
+  unsigned short sum;
+  unsigned char changed;
+  unsigned int addr;
+  
+  Serial.setTimeout( kEEByteWait );
+  
+  frame[0] = EE_INFO;
+  frame[1] = ( E2END + 1 ) & 0x0ff;
+  frame[2] = ( E2END + 1 ) >> 8;
+  frame[3] = kEEBlock;
+  frame[4] = kEEBinVersion;
+  sendFrame( 5 );
+  
+  idle = millis();
+  while( millis() - idle < kEEBinIdle ) {
+    if( !Serial.available() ) {
+      // fast blink in binary mode
+      digitalWrite( kLED, (millis() & 0x0080)? HIGH:LOW );
+      continue;
+    }
+    
+    frame[0] = Serial.read();
+    idle = millis();
+    
+    if(    frame[0] != EE_READ && frame[0] != EE_CHECK
+        && frame[0] != EE_WRITE && frame[0] != EE_QUIT ) {
+      nakFrame( EE_ERR_COMMAND );
+      continue;
+    }
+    if( !getFrame() ) continue;
+    
+    addr = frameAddr();
+    switch( frame[0] ) {
+    case( EE_READ ):
+      frame[0] = EE_DATA;
+      for( int b=0 ; b<frame[3] ; b++ )
+        frame[4+b] = EEPROM.read( addr + b );
+      sendFrame( 4 + frame[3] );
+      break;
+      
+    case( EE_CHECK ):
+      sum = 0xFFFF;
+      for( int b=0 ; b<frame[3] ; b++ )
+        sum = eeCrcAdd( sum, EEPROM.read( addr + b ));
+      frame[0] = EE_SUM;
+      frame[4] = sum & 0x0ff;
+      frame[5] = sum >> 8;
+      sendFrame( 6 );
+      break;
+      
+    case( EE_WRITE ):
+      // a write takes ms and wears the cell: skip the bytes already there
+      changed = 0;
+      for( int b=0 ; b<frame[3] ; b++ ) {
+        if( EEPROM.read( addr + b ) != frame[4+b] ) {
+          EEPROM.write( addr + b, frame[4+b] );
+          changed++;
+        }
+      }
+      frame[0] = EE_ACK;
+      frame[3] = changed;
+      sendFrame( 4 );
+      break;
+      
+    case( EE_QUIT ):
+      frame[0] = EE_ACK;
+      frame[1] = frame[2] = frame[3] = 0;
+      sendFrame( 4 );
+      return;
+    }
+  }
+}
+
 void handleSerial()
 {
   int chp = 0;
@@ -263,6 +405,7 @@ void handleSerial()
   else if( !strcmp( linebuf, "dump" ))     dumpEE();
   else if( !strcmp( linebuf, "print" ))    printEE();
   else if( !strcmp( linebuf, "record" ))   recordEE();
+  else if( !strcmp( linebuf, "bin" ))      binaryEE();
   else {
     // hack for now...
     linebuf[4] = '\0';
@@ -288,4 +431,4 @@ void loop()
   
   // slow pulse on idle...
   digitalWrite( kLED, (millis() & 0x0200)? HIGH:LOW );
-}
+}
@@ -0,0 +1,338 @@
+/* eex: push and pull EEProm images through EEExplorer's binary mode.
+ *  the protocol is described in ../eeproto.h */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "eeproto.h"
+
+/* EEExplorer.ino runs the port at 9600 baud */
+#define kBaud B9600
+
+/* a frame is sent this many times before we give up */
+#define kTries 4
+
+/* ms to wait for an answer: a full block of writes takes about 220 */
+#define kAnswerWait 2000
+
+static int port = -1;
+static unsigned int ee_size;
+static unsigned int ee_block;
+
+/* counts for the summary */
+static unsigned long blocks_sent = 0;
+static unsigned long bytes_changed = 0;
+static unsigned long retries = 0;
+
+
+/* the serial port */
+
+static int open_port( const char * name )
+{
+    struct termios tio;
+
+    port = open( name, O_RDWR | O_NOCTTY );
+    if( port < 0 ) return 0;
+    if( tcgetattr( port, &tio ) != 0 ) return 0;
+    cfmakeraw( &tio );
+    cfsetispeed( &tio, kBaud );
+    cfsetospeed( &tio, kBaud );
+    tio.c_cflag |= CLOCAL | CREAD;
+    return tcsetattr( port, TCSANOW, &tio ) == 0;
+}
+
+/* up to n bytes, or fewer if the line stays quiet for ms */
+static int get_bytes( unsigned char * buf, int n, int ms )
+{
+    struct pollfd p = { port, POLLIN, 0 };
+    int got = 0;
+    int r;
+
+    while( got < n ) {
+        r = poll( &p, 1, ms );
+        if( r < 0 && errno == EINTR ) continue;
+        if( r <= 0 ) break;
+        r = read( port, buf + got, n - got );
+        if( r <= 0 ) break;
+        got += r;
+    }
+    return got;
+}
+
+static void put_bytes( const unsigned char * buf, int n )
+{
+    int w;
+
+    while( n > 0 ) {
+        w = write( port, buf, n );
+        if( w < 0 && errno == EINTR ) continue;
+        if( w <= 0 ) return;
+        buf += w;
+        n -= w;
+    }
+}
+
+/* wait for the device to drop a bad frame, then forget what it sent.
+ *  It waits kEEByteWait for the rest of the frame, then as long for
+ *  the line to be quiet, before it answers */
+static void resync( int ms )
+{
+    unsigned char junk[ kEEFrame ];
+
+    while( get_bytes( junk, sizeof( junk ), ms ) > 0 );
+}
+
+
+/* frames */
+
+static int crc_ok( const unsigned char * f, int n )
+{
+    unsigned short crc = eeCrc( f, n );
+
+    return f[n] == ( crc & 0xFF ) && f[n + 1] == ( crc >> 8 );
+}
+
+static void add_crc( unsigned char * f, int n )
+{
+    unsigned short crc = eeCrc( f, n );
+
+    f[n] = crc & 0xFF;
+    f[n + 1] = crc >> 8;
+}
+
+/* send the command in cmd (n bytes, without the CRC), and read its
+ *  answer of want bytes (CRC included) into reply.  Damaged or
+ *  refused frames are sent again */
+static int transact( unsigned char * cmd, int n, unsigned char * reply, int want, unsigned char answer )
+{
+    int got;
+
+    add_crc( cmd, n );
+    for( int t = 0; t < kTries; t++ ) {
+        if( t > 0 ) retries++;
+        put_bytes( cmd, n + 2 );
+
+        got = get_bytes( reply, 1, kAnswerWait );
+        if( got == 1 && reply[0] == EE_NAK ) {
+            if( get_bytes( reply + 1, 3, kAnswerWait ) == 3 && crc_ok( reply, 2 )) continue;
+        } else if( got == 1 && reply[0] == answer ) {
+            got += get_bytes( reply + 1, want - 1, kAnswerWait );
+            /* the answer must be for this address */
+            if( got == want && crc_ok( reply, want - 2 )
+                && ( n < 3 || ( reply[1] == cmd[1] && reply[2] == cmd[2] ))) return 1;
+        }
+        resync( kEEByteWait + 100 );
+    }
+    return 0;
+}
+
+static void block_cmd( unsigned char * f, unsigned char cmd, unsigned int addr, unsigned int len )
+{
+    f[0] = cmd;
+    f[1] = addr & 0xFF;
+    f[2] = addr >> 8;
+    f[3] = len;
+}
+
+/* the CRC the device has for a block */
+static int device_sum( unsigned int addr, unsigned int len, unsigned short * sum )
+{
+    unsigned char f[ kEEFrame ], r[ kEEFrame ];
+
+    block_cmd( f, EE_CHECK, addr, len );
+    if( !transact( f, 4, r, 8, EE_SUM )) return 0;
+    *sum = r[4] | ( r[5] << 8 );
+    return 1;
+}
+
+
+/* getting in and out of binary mode */
+
+static int enter_binary( int reset_ms )
+{
+    unsigned char f[ 8 ];
+    unsigned char c;
+    int have = 0;
+
+    /* a real board restarts when the port opens */
+    if( reset_ms ) usleep( reset_ms * 1000 );
+
+    /* in case the device was left in binary mode, maybe half way
+     *  through a frame: back to the prompt.  At the prompt this is just
+     *  an unknown command */
+    resync( 2 * kEEByteWait + 100 );
+    f[0] = EE_QUIT;
+    add_crc( f, 1 );
+    put_bytes( f, 3 );
+    resync( kEEByteWait + 100 );
+
+    put_bytes( (const unsigned char *)"bin\n", 4 );
+
+    /* the echo and the prompt, then the info frame */
+    while( get_bytes( &c, 1, kAnswerWait ) == 1 ) {
+        if( have == 0 && c != EE_INFO ) continue;
+        f[have++] = c;
+        if( have < 7 ) continue;
+        if( crc_ok( f, 5 )) {
+            ee_size = f[1] | ( f[2] << 8 );
+            ee_block = f[3];
+            if( f[4] != kEEBinVersion ) {
+                fprintf( stderr, "eex: protocol version %d, not %d\n", f[4], kEEBinVersion );
+                return 0;
+            }
+            if( ee_block == 0 || ee_block > kEEBlock ) ee_block = kEEBlock;
+            return 1;
+        }
+        /* not it: look again from the next I */
+        do {
+            memmove( f, f + 1, --have );
+        } while( have > 0 && f[0] != EE_INFO );
+    }
+    fprintf( stderr, "eex: no answer from EEExplorer\n" );
+    return 0;
+}
+
+static void leave_binary( void )
+{
+    unsigned char f[ 8 ], r[ 8 ];
+
+    f[0] = EE_QUIT;
+    transact( f, 1, r, 6, EE_ACK );
+}
+
+
+/* the commands */
+
+static int pull( const char * filename )
+{
+    unsigned char f[ kEEFrame ], r[ kEEFrame ];
+    unsigned char * image;
+    unsigned int len;
+    FILE * fp;
+
+    image = (unsigned char *)malloc( ee_size );
+    if( !image ) return 0;
+    for( unsigned int addr = 0; addr < ee_size; addr += len ) {
+        len = ( ee_size - addr < ee_block ) ? ee_size - addr : ee_block;
+        block_cmd( f, EE_READ, addr, len );
+        if( !transact( f, 4, r, 4 + len + 2, EE_DATA )) {
+            fprintf( stderr, "eex: cannot read at %u\n", addr );
+            return 0;
+        }
+        memcpy( image + addr, r + 4, len );
+        blocks_sent++;
+    }
+
+    fp = fopen( filename, "wb" );
+    if( !fp || fwrite( image, 1, ee_size, fp ) != ee_size || fclose( fp ) != 0 ) {
+        perror( filename );
+        return 0;
+    }
+    printf( "%u bytes pulled in %lu blocks, %lu retries\n", ee_size, blocks_sent, retries );
+    return 1;
+}
+
+/* push writes only the blocks whose CRC differs; check only compares */
+static int push( const char * filename, int write_it )
+{
+    unsigned char f[ kEEFrame ], r[ kEEFrame ];
+    unsigned char image[ 65536 ];
+    unsigned short sum;
+    unsigned int size, len, differ = 0;
+    FILE * fp;
+
+    fp = fopen( filename, "rb" );
+    if( !fp ) {
+        perror( filename );
+        return 0;
+    }
+    size = fread( image, 1, sizeof( image ), fp );
+    fclose( fp );
+    if( size > ee_size ) {
+        fprintf( stderr, "eex: %s is %u bytes, the EEProm %u\n", filename, size, ee_size );
+        return 0;
+    }
+
+    for( unsigned int addr = 0; addr < size; addr += len ) {
+        len = ( size - addr < ee_block ) ? size - addr : ee_block;
+        if( !device_sum( addr, len, &sum )) goto lost;
+        if( sum == eeCrc( image + addr, len )) continue;
+
+        differ++;
+        if( !write_it ) {
+            printf( "block at %u differs\n", addr );
+            continue;
+        }
+        block_cmd( f, EE_WRITE, addr, len );
+        memcpy( f + 4, image + addr, len );
+        if( !transact( f, 4 + len, r, 6, EE_ACK )) goto lost;
+        blocks_sent++;
+        bytes_changed += r[3];
+
+        /* read back: a worn cell does not keep what was written */
+        if( !device_sum( addr, len, &sum )) goto lost;
+        if( sum != eeCrc( image + addr, len )) {
+            fprintf( stderr, "eex: block at %u did not verify\n", addr );
+            return 0;
+        }
+    }
+
+    if( write_it )
+        printf( "%u bytes pushed: %lu blocks sent, %lu bytes written, %lu retries\n",
+                size, blocks_sent, bytes_changed, retries );
+    else
+        printf( "%u bytes checked: %u blocks differ\n", size, differ );
+    return write_it || differ == 0;
+
+lost:
+    fprintf( stderr, "eex: no answer from EEExplorer\n" );
+    return 0;
+}
+
+
+static void usage( const char * prog )
+{
+    fprintf( stderr, "usage: %s [-w ms] port pull|push|check image\n", prog );
+    fprintf( stderr, "  -w ms   wait for the board to restart after the port opens (2000)\n" );
+    fprintf( stderr, "  pull    read the whole EEProm into the image file\n" );
+    fprintf( stderr, "  push    write the image, sending only the blocks that differ\n" );
+    fprintf( stderr, "  check   tell which blocks differ from the image\n" );
+    exit( 1 );
+}
+
+int main( int argc, char ** argv )
+{
+    int reset_ms = 2000;
+    int i = 1;
+    int ok;
+
+    if( i + 1 < argc && !strcmp( argv[i], "-w" )) {
+        reset_ms = atoi( argv[i + 1] );
+        i += 2;
+    }
+    if( argc - i != 3 ) usage( argv[0] );
+    if( strcmp( argv[i + 1], "pull" ) && strcmp( argv[i + 1], "push" ) && strcmp( argv[i + 1], "check" ))
+        usage( argv[0] );
+
+    if( !open_port( argv[i] )) {
+        perror( argv[i] );
+        return 1;
+    }
+    if( !enter_binary( reset_ms )) return 1;
+
+    if( !strcmp( argv[i + 1], "pull" ))
+        ok = pull( argv[i + 2] );
+    else
+        ok = push( argv[i + 2], !strcmp( argv[i + 1], "push" ));
+
+    leave_binary();
+    close( port );
+    return ok ? 0 : 1;
+}
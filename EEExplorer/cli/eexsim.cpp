@@ -0,0 +1,267 @@
+/* eexsim: EEExplorer.ino on the desktop, talking over a pty.
+ *  the slave side is printed at startup; point eex at it. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "eexsim.h"
+
+#define kSimEEWriteUs 3300
+
+void setup( void );
+void loop( void );
+
+SerialClass Serial;
+EEPROMClass EEPROM;
+
+static int master = -1;
+static unsigned long timeout_ms = 1000;
+static struct timespec started;
+static volatile sig_atomic_t stopping = 0;
+
+static unsigned char eeprom[ E2END + 1 ];
+static FILE * eefile = NULL;
+static unsigned long eewrites = 0;
+
+
+/* stopping: the EEProm traffic, then out */
+
+static void on_signal( int sig )
+{
+    (void)sig;
+    stopping = 1;
+}
+
+static void check_stop( void )
+{
+    if( !stopping ) return;
+    fprintf( stderr, "%lu EEProm writes\n", eewrites );
+    exit( 0 );
+}
+
+
+/* pins and time */
+
+void pinMode( int pin, int mode )
+{
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite( int pin, int value )
+{
+    (void)pin;
+    (void)value;
+}
+
+unsigned long millis( void )
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return ( now.tv_sec - started.tv_sec ) * 1000UL + ( now.tv_nsec - started.tv_nsec ) / 1000000L;
+}
+
+void delay( unsigned long ms )
+{
+    usleep( ms * 1000 );
+    check_stop();
+}
+
+
+/* Serial: the master side of the pty */
+
+void SerialClass::begin( long baud )
+{
+    (void)baud;
+}
+
+void SerialClass::flush( void )
+{
+    tcdrain( master );
+}
+
+/* waits a ms when there is nothing, so an idle loop() does not spin */
+int SerialClass::available( void )
+{
+    struct pollfd p = { master, POLLIN, 0 };
+    int n = 0;
+
+    check_stop();
+    if( ioctl( master, FIONREAD, &n ) == 0 && n > 0 ) return n;
+    poll( &p, 1, 1 );
+    if( ioctl( master, FIONREAD, &n ) != 0 ) return 0;
+    return n;
+}
+
+int SerialClass::read( void )
+{
+    unsigned char c;
+
+    if( !available() || ::read( master, &c, 1 ) != 1 ) return -1;
+    return c;
+}
+
+void SerialClass::setTimeout( unsigned long ms )
+{
+    timeout_ms = ms;
+}
+
+size_t SerialClass::readBytes( char * buf, size_t n )
+{
+    struct pollfd p = { master, POLLIN, 0 };
+    unsigned long until = millis() + timeout_ms;
+    unsigned long now;
+    size_t got = 0;
+    ssize_t r;
+
+    while( got < n && ( now = millis()) < until ) {
+        check_stop();
+        if( poll( &p, 1, until - now ) <= 0 ) continue;
+        r = ::read( master, buf + got, n - got );
+        if( r > 0 ) got += r;
+    }
+    return got;
+}
+
+size_t SerialClass::write( unsigned char c )
+{
+    return write( &c, 1 );
+}
+
+size_t SerialClass::write( const unsigned char * buf, size_t n )
+{
+    size_t done = 0;
+    ssize_t w;
+
+    while( done < n ) {
+        w = ::write( master, buf + done, n - done );
+        if( w < 0 && errno != EINTR ) break;
+        if( w > 0 ) done += w;
+    }
+    return done;
+}
+
+void SerialClass::print( const char * s )
+{
+    write( (const unsigned char *)s, strlen( s ));
+}
+
+void SerialClass::print( long v, int base )
+{
+    if( v < 0 ) {
+        print( "-" );
+        v = -v;
+    }
+    print( (unsigned long)v, base );
+}
+
+void SerialClass::print( unsigned long v, int base )
+{
+    char s[ 24 ];
+
+    snprintf( s, sizeof( s ), ( base == HEX ) ? "%lX" : "%lu", v );
+    print( s );
+}
+
+
+/* EEProm: the same file format as tbp -E */
+
+unsigned char EEPROMClass::read( int idx )
+{
+    return eeprom[ idx & E2END ];
+}
+
+void EEPROMClass::write( int idx, unsigned char val )
+{
+    idx &= E2END;
+    eeprom[ idx ] = val;
+    eewrites++;
+    usleep( kSimEEWriteUs );
+    if( eefile ) {
+        fseek( eefile, idx, SEEK_SET );
+        fputc( val, eefile );
+        fflush( eefile );
+    }
+}
+
+static int open_eeprom( const char * filename )
+{
+    eefile = fopen( filename, "r+b" );
+    if( eefile ) {
+        if( fread( eeprom, 1, sizeof( eeprom ), eefile )) { /* a short file stays erased at the end */ }
+    } else {
+        eefile = fopen( filename, "w+b" );
+        if( !eefile ) return 0;
+        fwrite( eeprom, 1, sizeof( eeprom ), eefile );
+        fflush( eefile );
+    }
+    return 1;
+}
+
+
+/* the pty.  The slave stays open here too, raw, so the sketch does not
+ *  see a hangup between two runs of eex, and nothing is echoed back */
+
+static const char * open_pty( void )
+{
+    struct termios tio;
+    const char * name;
+    int slave;
+
+    master = posix_openpt( O_RDWR | O_NOCTTY );
+    if( master < 0 || grantpt( master ) != 0 || unlockpt( master ) != 0 ) return NULL;
+    name = ptsname( master );
+    if( !name ) return NULL;
+    slave = open( name, O_RDWR | O_NOCTTY );
+    if( slave < 0 || tcgetattr( slave, &tio ) != 0 ) return NULL;
+    cfmakeraw( &tio );
+    if( tcsetattr( slave, TCSANOW, &tio ) != 0 ) return NULL;
+    return name;
+}
+
+
+static void usage( const char * prog )
+{
+    fprintf( stderr, "usage: %s [-E eeprom]\n", prog );
+    fprintf( stderr, "  -E eeprom   keep the EEProm contents in this file\n" );
+    exit( 1 );
+}
+
+int main( int argc, char ** argv )
+{
+    const char * name;
+
+    memset( eeprom, 0xFF, sizeof( eeprom )); /* erased */
+    for( int i = 1; i < argc; i++ ) {
+        if( !strcmp( argv[i], "-E" ) && i + 1 < argc ) {
+            if( !open_eeprom( argv[++i] )) {
+                perror( argv[i] );
+                return 1;
+            }
+        } else {
+            usage( argv[0] );
+        }
+    }
+
+    name = open_pty();
+    if( !name ) {
+        perror( "pty" );
+        return 1;
+    }
+    signal( SIGINT, on_signal );
+    signal( SIGTERM, on_signal );
+    clock_gettime( CLOCK_MONOTONIC, &started );
+
+    printf( "EEExplorer on %s\n", name );
+    fflush( stdout );
+
+    setup();
+    for( ;; ) loop();
+}
@@ -0,0 +1,65 @@
+/* desktop stand-ins for the Arduino core used by EEExplorer.ino,
+ *  implemented in eexsim.cpp.  Serial is the master side of a pty. */
+
+#ifndef _EEXSIM_H_
+#define _EEXSIM_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef boolean
+ #define boolean int
+ #define true 1
+ #define false 0
+#endif
+
+/* the sizes of a '328 */
+#define FLASHEND 0x7FFF
+#define RAMEND   0x08FF
+#define E2END    1023
+
+#define INPUT  0
+#define OUTPUT 1
+#define LOW    0
+#define HIGH   1
+
+#define DEC 10
+#define HEX 16
+
+void pinMode( int pin, int mode );
+void digitalWrite( int pin, int value );
+unsigned long millis( void );
+void delay( unsigned long ms );
+
+class SerialClass
+{
+public:
+    void begin( long baud );
+    operator bool() { return true; }
+    void flush( void );
+    int available( void );
+    int read( void );
+    void setTimeout( unsigned long ms );
+    size_t readBytes( char * buf, size_t n );
+    size_t write( unsigned char c );
+    size_t write( const unsigned char * buf, size_t n );
+    void print( const char * s );
+    void print( int v, int base = DEC )           { print( (long)v, base ); }
+    void print( unsigned int v, int base = DEC )  { print( (unsigned long)v, base ); }
+    void print( long v, int base = DEC );
+    void print( unsigned long v, int base = DEC );
+    void println( const char * s = "" )           { print( s ); print( "\r\n" ); }
+};
+extern SerialClass Serial;
+
+/* in memory, and in a file if one is given; a write takes 3.3 ms */
+class EEPROMClass
+{
+public:
+    unsigned char read( int idx );
+    void write( int idx, unsigned char val );
+};
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,71 @@
+// eeproto.h
+//
+//  the binary block protocol of EEExplorer, shared by the sketch and
+//  the host tool (cli/eex.cpp)
+//
+//  "bin" typed at the prompt switches to binary mode, and the device
+//  answers with an info frame.  From there on every frame is a command
+//  byte, its fields, and a CRC-16/CCITT (start 0xFFFF, low byte first)
+//  of all the bytes before it.  Addresses and sizes are low byte first.
+//
+//   host                            device
+//   R addr len crc                  D addr len data[len] crc
+//   C addr len crc                  S addr len sum crc   (sum: CRC of the bytes)
+//   W addr len data[len] crc        A addr changed crc   (only changed bytes written)
+//   Q crc                           A 0 0 crc, back to the prompt
+//                                   N error crc          (bad frame, try again)
+//
+//  info frame: I size blocksize version crc
+//
+//  The device leaves binary mode by itself after kEEBinIdle ms
+//  without a command.
+
+
+#ifndef _EEPROTO_H_
+#define _EEPROTO_H_
+
+#define kEEBinVersion 1
+
+// largest block moved by one frame: 64 bytes is the AVR serial buffer
+#define kEEBlock      64
+
+// largest frame: W, address, length, data and CRC
+#define kEEFrame      ( 1 + 2 + 1 + kEEBlock + 2 )
+
+// ms to wait for the rest of a frame, and for the next command
+#define kEEByteWait   500
+#define kEEBinIdle    10000
+
+#define EE_INFO     'I'
+#define EE_READ     'R'
+#define EE_DATA     'D'
+#define EE_CHECK    'C'
+#define EE_SUM      'S'
+#define EE_WRITE    'W'
+#define EE_ACK      'A'
+#define EE_QUIT     'Q'
+#define EE_NAK      'N'
+
+// error codes in a N frame
+#define EE_ERR_CRC      1   // the frame was damaged
+#define EE_ERR_RANGE    2   // past the end of the EEProm, or a bad length
+#define EE_ERR_COMMAND  3   // not a command
+#define EE_ERR_TIMEOUT  4   // the frame stopped half way
+
+// CRC-16/CCITT, bit by bit like the one in TinyBasicPlus/estore.cpp
+static inline unsigned short eeCrcAdd( unsigned short crc, unsigned char b )
+{
+  crc ^= (unsigned short)b << 8;
+  for( unsigned char i=0 ; i<8 ; i++ )
+    crc = ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : crc << 1;
+  return crc;
+}
+
+static inline unsigned short eeCrc( const unsigned char *buf, unsigned int n )
+{
+  unsigned short crc = 0xFFFF;
+  while( n-- ) crc = eeCrcAdd( crc, *buf++ );
+  return crc;
+}
+
+#endif
@@ -73,69 +73,134 @@ char eliminateCompileErrors = 1; // fix to suppress arduino build errors
 #include "keywords.h"
 #include "streamio.h"
 #include "usermem.h"
+#include "timer.h"
+#include "events.h"
+#include "pinio.h"
+#include "estore.h"
+#include "fileio.h"
+#include "pager.h"
+#include "arrays.h"
+#include "jit.h"
+#include "fused.h"
+#include "link.h"
+#include "data.h"
+#include "minify.h"
 
 streamioClass IO;
 usermemClass mem;
+timerClass timers;
+eventsClass events;
+pinioClass pins;
+#ifdef ENABLE_EEPROM
+estoreClass estore;
+#endif
+#ifdef ENABLE_FILEIO
+fileioClass fileio;
+#endif
+#ifdef ENABLE_PAGING
+pagerClass pager;
+#endif
+#ifdef ENABLE_ARRAYS
+arrayClass arrays;
+#endif
+#ifdef ENABLE_JIT
+jitClass jit;
+#endif
+#ifdef ENABLE_FUSED
+fusedClass fused;
+#endif
+#ifdef ENABLE_LINK
+linkClass linker;
+#endif
+#ifdef ENABLE_DATA
+dataClass data;
+#endif
+#ifdef ENABLE_MINIFY
+minifyClass minify;
+#endif
 
-static boolean inhibitOutput = false;
-static boolean runAfterLoad = false;
-static boolean triggerRun = false;
+boolean inhibitOutput = false;
+boolean runAfterLoad = false;
+boolean triggerRun = false;
 
 /***************************************************************************/
 void loop()
 {
     unsigned char *start;
     unsigned char *newEnd;
-    unsigned char linelen;
+    unsigned char *statement;
+    unsigned int linelen;
     boolean isDigital;
     boolean alsoWait = false;
     int val;
+#ifdef ENABLE_LINK
+    unsigned char *jump;
+#endif
 
 #ifdef ARDUINO
 #ifdef ENABLE_TONES
     noTone(kPiezoPin);
 #endif
 #endif
+    timers.reset();
+    pins.reset();
 
-    mem.program_start = mem.program;
-    mem.program_reset();
-    mem.sp = mem.program + sizeof(mem.program); // Needed for printnum
-#ifdef ALIGN_MEMORY
-    // Ensure these memory blocks start on even pages
-    mem.stack_limit = ALIGN_DOWN(mem.program + sizeof(mem.program) - STACK_SIZE);
-    mem.variables_begin = ALIGN_DOWN(mem.stack_limit - 27 * VAR_SIZE);
-#else
-    mem.stack_limit = mem.program + sizeof(mem.program) - STACK_SIZE;
-    mem.variables_begin = mem.stack_limit - 27 * VAR_SIZE;
-#endif
+    mem.begin();
 
     // memory free
     IO.printnum(mem.free_mem());
     IO.printmsg(memorymsg);
-#ifdef ARDUINO
 #ifdef ENABLE_EEPROM
     // eprom size
-    IO.printnum(E2END + 1);
+    IO.printnum(EE_SIZE);
     IO.printmsg(eeprommsg);
+#ifdef ENABLE_EAUTORUN
+    // load and run the program in the eeprom, if there is an intact one
+    // and no other program is being loaded
+    if (IO.inStream == streamioClass::streamType::kStreamSerial && estore.begin_read())
+    {
+        if (estore.tokenized())
+            triggerRun = estore.load();
+        else
+        {
+            IO.inStream = streamioClass::streamType::kStreamEEProm;
+            inhibitOutput = true;
+            runAfterLoad = true;
+        }
+    }
+#endif /* ENABLE_EAUTORUN */
 #endif /* ENABLE_EEPROM */
-#endif /* ARDUINO */
 
 warmstart:
     // this signifies that it is running in 'direct' mode.
     mem.current_line = 0;
-    mem.sp = mem.program + sizeof(mem.program);
+    mem.sp = mem.memory_end();
+    timers.stop();
+    pins.unwatch();
+    events.reset();
     IO.printmsg(okmsg);
 
 prompt:
     if (triggerRun)
     {
         triggerRun = false;
-        mem.current_line = mem.program_start;
+#ifdef ENABLE_LINK
+        if (linker.link())
+            goto warmstart;
+#endif
+#ifdef ENABLE_DATA
+        if (data.build())
+            goto warmstart;
+#endif
+        mem.linenum = 0;
+        mem.current_line = mem.findline();
         goto execline;
     }
 
     IO.getln('>');
     mem.toUppercaseBuffer();
+    if (!mem.bind_names(mem.program_end + sizeof(LINENUM)))
+        goto qsorry;
     mem.txtpos = mem.program_end + sizeof(unsigned short);
 
     // Find the end of the freshly entered line
@@ -144,7 +209,7 @@ prompt:
     // Move it to the end of program_memory
     {
         unsigned char *dest;
-        dest = mem.variables_begin - 1;
+        dest = mem.heap_begin - 1;
         while (1)
         {
             *dest = *mem.txtpos;
@@ -165,15 +230,40 @@ prompt:
     if (mem.linenum == 0xFFFF)
         goto qhow;
 
+    // the compiled and fused lines point into the program being changed
+#ifdef ENABLE_JIT
+    jit.reset();
+#endif
+#ifdef ENABLE_FUSED
+    fused.reset();
+#endif
+#ifdef ENABLE_LINK
+    linker.reset();
+#endif
+#ifdef ENABLE_DATA
+    data.reset();
+#endif
+
+#ifdef ENABLE_PAGING
+    // typing in a line ends paged mode, with an empty program
+    if (pager.active)
+    {
+        pager.stop();
+        mem.program_end = mem.program_start;
+    }
+#endif
+
     // Find the length of what is left, including the (yet-to-be-populated) line header
     linelen = 0;
     while (mem.txtpos[linelen] != NL)
         linelen++;
-    linelen++;                                        // Include the NL in the line length
-    linelen += sizeof(unsigned short) + sizeof(char); // Add space for the line number and line length
+    linelen++;              // Include the NL in the line length
+    linelen += LINE_HEADER; // Add space for the line number and line length
+    if (linelen > (LINELEN)~0)
+        goto qsorry;
 
     // Now we have the number, add the line header.
-    mem.txtpos -= 3;
+    mem.txtpos -= LINE_HEADER;
 
 #ifdef ALIGN_MEMORY
     // Line starts should always be on 16-bit pages
@@ -183,7 +273,7 @@ prompt:
         linelen++;
         // As the start of the line has moved, the data should move as well
         unsigned char *tomove;
-        tomove = mem.txtpos + 3;
+        tomove = mem.txtpos + LINE_HEADER;
         while (tomove < mem.txtpos + linelen - 1)
         {
             *tomove = *(tomove + 1);
@@ -193,7 +283,7 @@ prompt:
 #endif
 
     *((unsigned short *)mem.txtpos) = mem.linenum;
-    mem.txtpos[sizeof(LINENUM)] = linelen;
+    LINE_LENGTH(mem.txtpos) = linelen;
 
     // Merge it into the rest of the program
     start = mem.findline();
@@ -204,7 +294,7 @@ prompt:
         unsigned char *dest, *from;
         unsigned tomove;
 
-        from = start + start[sizeof(LINENUM)];
+        from = start + LINE_LENGTH(start);
         dest = start;
 
         tomove = mem.program_end - from;
@@ -218,7 +308,7 @@ prompt:
         mem.program_end = dest;
     }
 
-    if (mem.txtpos[sizeof(LINENUM) + sizeof(char)] == NL) // If the line has no txt, it was just a delete
+    if (mem.txtpos[LINE_HEADER] == NL) // If the line has no txt, it was just a delete
         goto prompt;
 
     // Make room for the new line, either all in one hit or lots of little shuffles
@@ -260,11 +350,11 @@ prompt:
 
 unimplemented:
     IO.printmsg(unimplimentedmsg);
-    goto prompt;
+    goto stopped;
 
 qhow:
     IO.printmsg(howmsg);
-    goto prompt;
+    goto stopped;
 
 qwhat:
     IO.printmsgNoNL(whatmsg);
@@ -278,6 +368,13 @@ qwhat:
         *mem.txtpos = tmp;
     }
     IO.line_terminator();
+
+stopped:
+    // back to direct mode without the Ok. prompt
+    mem.current_line = 0;
+    timers.stop();
+    pins.unwatch();
+    events.reset();
     goto prompt;
 
 qsorry:
@@ -304,20 +401,34 @@ interperateAtTxtpos:
         goto warmstart;
     }
 
+    // pending ON ... GOSUB handlers run before the next statement
+    timers.check();
+    pins.check();
+    if (events.ready() && mem.current_line != NULL)
+        goto dispatch_event;
+
+#ifdef ENABLE_FUSED
+    // the first statement of a line may have a fused handler
+    if (mem.current_line != NULL && mem.txtpos == mem.current_line + LINE_HEADER
+#ifdef ENABLE_PAGING
+        && !pager.active
+#endif
+        && fused.find(mem.current_line) != NULL)
+        goto run_fused;
+unfused:
+#endif
+    statement = mem.txtpos;
     mem.scantable(keywords);
 
     switch (mem.table_index)
     {
     case KW_DELAY:
-    {
-#ifdef ARDUINO
-        val = mem.expression();
-        delay(val);
-        goto execnextline;
-#else
-        goto unimplemented;
-#endif
-    }
+    case KW_SLEEP:
+        goto sleep;
+    case KW_ON:
+        goto on;
+    case KW_SAMPLE:
+        goto sample;
 
     case KW_FILES:
         goto files;
@@ -335,7 +446,19 @@ interperateAtTxtpos:
         mem.program_reset();
         goto prompt;
     case KW_RUN:
-        mem.current_line = mem.program_start;
+        mem.heap_reset();
+#ifdef ENABLE_LINK
+        // a program with bad jumps or loops does not start
+        if (linker.link())
+            goto warmstart;
+#endif
+#ifdef ENABLE_DATA
+        // and neither does one with a bad DATA
+        if (data.build())
+            goto warmstart;
+#endif
+        mem.linenum = 0;
+        mem.current_line = mem.findline();
         goto execline;
     case KW_SAVE:
         goto save;
@@ -344,8 +467,9 @@ interperateAtTxtpos:
     case KW_LET:
         goto assignment;
     case KW_IF:
-        short int val;
-        val = mem.expression();
+        VALUE val;
+        // a fixed point 0.5 is true
+        val = mem.typed_expression();
         if (mem.expression_error || *mem.txtpos == NL)
             goto qhow;
         if (val != 0)
@@ -353,6 +477,14 @@ interperateAtTxtpos:
         goto execnextline;
 
     case KW_GOTO:
+#ifdef ENABLE_LINK
+        jump = linker.target(mem.txtpos);
+        if (jump != NULL)
+        {
+            mem.current_line = jump;
+            goto execline;
+        }
+#endif
         mem.linenum = mem.expression();
         if (mem.expression_error || *mem.txtpos != NL)
             goto qhow;
@@ -399,13 +531,13 @@ interperateAtTxtpos:
 #ifdef ENABLE_TONES
     case KW_TONEW:
         alsoWait = true;
+        // fall through
     case KW_TONE:
         goto tonegen;
     case KW_NOTONE:
         goto tonestop;
 #endif
 
-#ifdef ARDUINO
 #ifdef ENABLE_EEPROM
     case KW_EFORMAT:
         goto eformat;
@@ -418,71 +550,103 @@ interperateAtTxtpos:
     case KW_ECHAIN:
         goto echain;
 #endif
+#ifdef ENABLE_PAGING
+    case KW_PAGE:
+        goto page;
+#endif
+#ifdef ENABLE_ARRAYS
+    case KW_DIM:
+        goto dim;
+    case KW_AFILL:
+    case KW_ACOPY:
+    case KW_AADD:
+    case KW_ASCALE:
+        goto bulk;
+#endif
+#ifdef ENABLE_FIXED
+    case KW_FIXED:
+        goto fixed;
+#endif
+#ifdef ENABLE_DATA
+    case KW_DATA:
+        // its items are in the table: on to the next statement
+        while (*mem.txtpos != NL && *mem.txtpos != ':')
+            mem.txtpos++;
+        goto run_next_statement;
+    case KW_READ:
+    case KW_RESTORE:
+        goto read;
 #endif
 
     case KW_DEFAULT:
         goto assignment;
     default:
-        break;
+        // a statement left out of this build
+        goto unimplemented;
     }
 
 execnextline:
     if (mem.current_line == NULL) // Processing direct commands?
         goto prompt;
-    mem.current_line += mem.current_line[sizeof(LINENUM)];
+    mem.current_line += LINE_LENGTH(mem.current_line);
 
 execline:
+#ifdef ENABLE_PAGING
+    if (pager.active)
+    {
+        if (mem.current_line != NULL && *((LINENUM *)mem.current_line) == 0) // end of a page
+            mem.current_line = pager.next(mem.current_line);
+        if (mem.current_line == NULL) // every page in memory is held by a FOR or GOSUB
+            goto qsorry;
+    }
+#endif
     if (mem.current_line == mem.program_end) // Out of lines to run
         goto warmstart;
-    mem.txtpos = mem.current_line + sizeof(LINENUM) + sizeof(char);
+    mem.txtpos = mem.current_line + LINE_HEADER;
+#ifdef ENABLE_JIT
+    // pages move lines around under the code, so paged programs are not compiled
+#ifdef ENABLE_PAGING
+    if (!pager.active)
+#endif
+    {
+        LINELEN r = jit.run(mem.current_line);
+        if (r == JIT_LINE_DONE)
+            goto execnextline;
+        mem.txtpos = mem.current_line + r;
+    }
+#endif
     goto interperateAtTxtpos;
 
-#ifdef ARDUINO
 #ifdef ENABLE_EEPROM
 elist:
-{
-    int i;
-    for (i = 0; i < (E2END + 1); i++)
-    {
-        val = EEPROM.read(i);
-
-        if (val == '\0')
-        {
-            goto execnextline;
-        }
-        IO.outchar_printable(val);
-    }
-}
+    // the header tells how much there is to list
+    if (estore.begin_read())
+        estore.list();
     goto execnextline;
 
 eformat:
-{
-    for (int i = 0; i < E2END; i++)
-    {
-        if ((i & 0x03f) == 0x20)
-            IO.outchar('.');
-        EEPROM.write(i, 0);
-    }
-    IO.outchar(LF);
-}
+    estore.format();
     goto execnextline;
 
 esave:
+    // ESAVE [MIN]
 {
-    IO.outStream = streamioClass::streamType::kStreamEEProm;
-    eepos = 0;
-
-    // copied from "List"
-    mem.list_line = mem.findline();
-    while (mem.list_line != mem.program_end)
+    boolean minified = false;
+#ifdef ENABLE_PAGING
+    if (pager.active)
+        goto unimplemented;
+#endif
+#ifdef ENABLE_MINIFY
+    mem.scantable(min_tab);
+    if (mem.table_index == 0)
     {
-        IO.printline();
+        if (!minify.begin(mem.txtpos))
+            goto qsorry;
+        minified = true;
     }
-    IO.outchar('\0');
-
-    // go back to standard output, close the file
-    IO.outStream = streamioClass::streamType::kStreamSerial;
-
+#endif
+    if (!estore.save(minified))
+        goto qsorry;
     goto warmstart;
 }
 
@@ -490,25 +654,51 @@ echain:
     runAfterLoad = true;
 
 eload:
+    // refuse a damaged program before clearing the current one
+    if (!estore.begin_read())
+    {
+        runAfterLoad = false;
+        IO.printmsg(eeemptymsg);
+        goto stopped;
+    }
+
     // clear the program
     mem.program_reset();
 
-    // load from a file into memory
-    eepos = 0;
+    // a tokenized program goes straight into memory
+    if (estore.tokenized())
+    {
+        if (!estore.load())
+        {
+            runAfterLoad = false;
+            goto qsorry;
+        }
+        if (runAfterLoad)
+        {
+            runAfterLoad = false;
+            triggerRun = true;
+        }
+        goto warmstart;
+    }
+
+    // a text program is typed in from the eeprom
     IO.inStream = streamioClass::streamType::kStreamEEProm;
     inhibitOutput = true;
     goto warmstart;
 #endif /* ENABLE_EEPROM */
-#endif
 
 input:
 {
     unsigned char var;
-    int value;
+    VALUE value;
+    boolean to_fixed = false;
     mem.ignore_blanks();
-    if (mem.isNotAlpha())
+    if (mem.isNotVariable())
         goto qwhat;
     var = *mem.txtpos;
+#ifdef ENABLE_FIXED
+    to_fixed = mem.is_fixed(var);
+#endif
     mem.txtpos++;
     mem.ignore_blanks();
     if (*mem.txtpos != NL && *mem.txtpos != ':')
@@ -517,9 +707,12 @@ inputagain:
     mem.tmptxtpos = mem.txtpos;
     IO.getln('?');
     mem.toUppercaseBuffer();
+    // the answer may name a variable of the program, not a new one
+    if (!mem.bind_names(mem.program_end + sizeof(LINENUM), false))
+        goto inputagain;
     mem.txtpos = mem.program_end + sizeof(unsigned short);
     mem.ignore_blanks();
-    value = mem.expression();
+    value = mem.expression_as(to_fixed);
     if (mem.expression_error)
         goto inputagain;
     mem.set_var(var, value);
@@ -531,11 +724,15 @@ inputagain:
 forloop:
 {
     unsigned char var;
-    short int initial, step, terminal;
+    VALUE initial, step, terminal;
+    boolean to_fixed = false;
     mem.ignore_blanks();
-    if (mem.isNotAlpha())
+    if (mem.isNotVariable())
         goto qwhat;
     var = *mem.txtpos;
+#ifdef ENABLE_FIXED
+    to_fixed = mem.is_fixed(var);
+#endif
     mem.txtpos++;
     mem.ignore_blanks();
     if (*mem.txtpos != '=')
@@ -543,7 +740,8 @@ forloop:
     mem.txtpos++;
     mem.ignore_blanks();
 
-    initial = mem.expression();
+    // the loop counts in the type of its variable
+    initial = mem.expression_as(to_fixed);
     if (mem.expression_error)
         goto qwhat;
 
@@ -551,17 +749,21 @@ forloop:
     if (mem.table_index != 0)
         goto qwhat;
 
-    terminal = mem.expression();
+    terminal = mem.expression_as(to_fixed);
     if (mem.expression_error)
         goto qwhat;
 
     mem.scantable(step_tab);
     if (mem.table_index == 0)
     {
-        step = mem.expression();
+        step = mem.expression_as(to_fixed);
         if (mem.expression_error)
             goto qwhat;
     }
+#ifdef ENABLE_FIXED
+    else if (to_fixed)
+        step = 1 << kFixedShift;
+#endif
     else
         step = 1;
     mem.ignore_blanks();
@@ -571,45 +773,409 @@ forloop:
     if (!mem.expression_error && *mem.txtpos == NL)
     {
         struct stack_for_frame *f;
-        if (mem.sp + sizeof(struct stack_for_frame) < mem.stack_limit)
+        if (mem.sp - sizeof(struct stack_for_frame) < mem.stack_limit)
             goto qsorry;
 
         mem.sp -= sizeof(struct stack_for_frame);
         f = (struct stack_for_frame *)mem.sp;
-        ((short int *)mem.variables_begin)[var - 'A'] = initial;
+        *mem.var(var) = initial;
         f->frame_type = STACK_FOR_FLAG;
         f->for_var = var;
         f->terminal = terminal;
         f->step = step;
-        f->txtpos = mem.txtpos;
-        f->current_line = mem.current_line;
+        f->txtpos = mem.offset(mem.txtpos);
+        f->current_line = mem.offset(mem.current_line);
         goto run_next_statement;
     }
 }
     goto qhow;
 
 gosub:
-    mem.linenum = mem.expression();
+#ifdef ENABLE_LINK
+    // a line number RUN has checked: the line is known
+    jump = linker.target(mem.txtpos);
+    if (jump != NULL)
+    {
+        mem.find_newline();
+        mem.expression_error = 0;
+    }
+    else
+#endif
+        mem.linenum = mem.expression();
     if (!mem.expression_error && *mem.txtpos == NL)
     {
         struct stack_gosub_frame *f;
-        if (mem.sp + sizeof(struct stack_gosub_frame) < mem.stack_limit)
+        if (mem.sp - sizeof(struct stack_gosub_frame) < mem.stack_limit)
             goto qsorry;
 
         mem.sp -= sizeof(struct stack_gosub_frame);
         f = (struct stack_gosub_frame *)mem.sp;
         f->frame_type = STACK_GOSUB_FLAG;
-        f->txtpos = mem.txtpos;
-        f->current_line = mem.current_line;
+        f->txtpos = mem.offset(mem.txtpos);
+        f->current_line = mem.offset(mem.current_line);
+#ifdef ENABLE_LINK
+        if (jump != NULL)
+        {
+            mem.current_line = jump;
+            goto execline;
+        }
+#endif
         mem.current_line = mem.findline();
         goto execline;
     }
     goto qhow;
 
+dispatch_event:
+{
+    // like a GOSUB from just before the statement we were about to run
+    struct stack_gosub_frame *f;
+    if (mem.sp - sizeof(struct stack_gosub_frame) < mem.stack_limit)
+        goto qsorry;
+
+    mem.sp -= sizeof(struct stack_gosub_frame);
+    f = (struct stack_gosub_frame *)mem.sp;
+    f->frame_type = STACK_EVENT_FLAG;
+    f->txtpos = mem.offset(mem.txtpos);
+    f->current_line = mem.offset(mem.current_line);
+    events.busy = true;
+    mem.linenum = events.next();
+    mem.current_line = mem.findline();
+    goto execline;
+}
+
+on:
+{
+    // ON TIMER ms GOSUB line
+    // ON PIN pin CHANGE GOSUB line
+    unsigned char source;
+    VALUE arg;
+
+    mem.scantable(on_tab);
+    source = mem.table_index;
+    if (source == ON_UNKNOWN)
+        goto qwhat;
+    arg = mem.expression();
+    if (mem.expression_error || arg < 0)
+        goto qhow;
+    if (source == ON_PIN)
+    {
+        if (!pins.valid(arg))
+            goto qhow;
+        mem.scantable(change_tab);
+        if (mem.table_index != 0)
+            goto qwhat;
+    }
+    mem.scantable(gosub_tab);
+    if (mem.table_index != 0)
+        goto qwhat;
+    mem.linenum = mem.expression();
+    if (mem.expression_error)
+        goto qhow;
+    if (*mem.txtpos != NL && *mem.txtpos != ':')
+        goto qwhat;
+#if VALUE_BITS > 16
+    // the timers keep their period in 16 bits
+    if (source == ON_TIMER && arg > 65535)
+        goto qhow;
+#endif
+    if (source == ON_TIMER && !timers.every(arg, mem.linenum))
+        goto qsorry;
+    if (source == ON_PIN && !pins.watch(arg, mem.linenum))
+        goto qsorry;
+    goto run_next_statement;
+}
+
+sample:
+{
+    // SAMPLE pin, count, interval_us
+    VALUE pin, count, interval;
+
+    pin = mem.expression();
+    if (mem.expression_error)
+        goto qwhat;
+    mem.ignore_blanks();
+    if (*mem.txtpos != ',')
+        goto qwhat;
+    mem.txtpos++;
+    count = mem.expression();
+    if (mem.expression_error)
+        goto qwhat;
+    mem.ignore_blanks();
+    if (*mem.txtpos != ',')
+        goto qwhat;
+    mem.txtpos++;
+    interval = mem.expression();
+    if (mem.expression_error)
+        goto qwhat;
+    if (*mem.txtpos != NL && *mem.txtpos != ':')
+        goto qwhat;
+    if (!pins.valid(pin) || count <= 0 || interval < 0)
+        goto qhow;
+#if VALUE_BITS > 16
+    // the room and the count are kept in 16 bits
+    if (count > 65535)
+        goto qhow;
+#endif
+
+    // the buffer is kept for the next SAMPLEs.  A bigger one replaces it:
+    // the old one is given back if nothing was allocated below it since,
+    // else it stays taken until the next RUN or NEW.
+    if ((unsigned short)count > mem.sample_room)
+    {
+        if ((unsigned char *)mem.samples == mem.heap_begin)
+            mem.heap_begin += mem.sample_room * sizeof(short int);
+        mem.sample_count = 0;
+        mem.sample_room = 0;
+        mem.samples = (short int *)mem.heap_alloc(count * sizeof(short int));
+        if (mem.samples == NULL)
+            goto qsorry;
+        mem.sample_room = count;
+    }
+    pins.sample(pin, mem.samples, count, interval);
+    mem.sample_count = count;
+    goto run_next_statement;
+}
+
+#ifdef ENABLE_ARRAYS
+dim:
+    // DIM var(n)[, var(n)...]: an array of elements 0 to n
+{
+    unsigned char var;
+    VALUE n;
+
+    while (1)
+    {
+        mem.ignore_blanks();
+        if (mem.isNotVariable())
+            goto qwhat;
+        var = *mem.txtpos++;
+        if (*mem.txtpos != '(')
+            goto qwhat;
+        mem.txtpos++;
+        n = mem.expression();
+        if (mem.expression_error || *mem.txtpos != ')')
+            goto qwhat;
+        mem.txtpos++;
+        if (n < 0 || (UVALUE)n > 65534 || arrays.find(var) != NULL)
+            goto qhow;
+        if (arrays.dim(var, n + 1) == NULL)
+            goto qsorry;
+        mem.ignore_blanks();
+        if (*mem.txtpos != ',')
+            break;
+        mem.txtpos++;
+    }
+    if (*mem.txtpos != NL && *mem.txtpos != ':')
+        goto qwhat;
+    goto run_next_statement;
+}
+
+bulk:
+    // AFILL a,value  ACOPY a,b  AADD a,b  ASCALE a,mul[,div]
+{
+    unsigned char op = mem.table_index;
+    array_header *a, *b = NULL;
+    VALUE value = 0, div = 1;
+
+    mem.ignore_blanks();
+    if (mem.isNotVariable())
+        goto qwhat;
+    a = arrays.find(*mem.txtpos++);
+    if (a == NULL)
+        goto qhow;
+    mem.ignore_blanks();
+    if (*mem.txtpos != ',')
+        goto qwhat;
+    mem.txtpos++;
+    mem.ignore_blanks();
+    if (op == KW_ACOPY || op == KW_AADD)
+    {
+        if (mem.isNotVariable())
+            goto qwhat;
+        b = arrays.find(*mem.txtpos++);
+        if (b == NULL)
+            goto qhow;
+        mem.ignore_blanks();
+    }
+    else
+    {
+        value = mem.expression();
+        if (mem.expression_error)
+            goto qwhat;
+        if (op == KW_ASCALE && *mem.txtpos == ',')
+        {
+            mem.txtpos++;
+            div = mem.expression();
+            if (mem.expression_error)
+                goto qwhat;
+            if (div == 0)
+                goto qhow;
+        }
+    }
+    if (*mem.txtpos != NL && *mem.txtpos != ':')
+        goto qwhat;
+
+    switch (op)
+    {
+    case KW_AFILL:
+        arrays.fill(a, value);
+        break;
+    case KW_ACOPY:
+        arrays.copy(a, b);
+        break;
+    case KW_AADD:
+        arrays.add(a, b);
+        break;
+    default:
+        arrays.scale(a, value, div);
+        break;
+    }
+    goto run_next_statement;
+}
+#endif /* ENABLE_ARRAYS */
+
+#ifdef ENABLE_FIXED
+fixed:
+    // FIXED var[, var...]: fixed point from now on, until RUN or NEW
+{
+    while (1)
+    {
+        mem.ignore_blanks();
+        if (mem.isNotVariable())
+            goto qwhat;
+        if (!mem.make_fixed(*mem.txtpos))
+            goto qhow;
+        mem.txtpos++;
+        mem.ignore_blanks();
+        if (*mem.txtpos != ',')
+            break;
+        mem.txtpos++;
+    }
+    if (*mem.txtpos != NL && *mem.txtpos != ':')
+        goto qwhat;
+#ifdef ENABLE_JIT
+    // the compiled lines took the variable for an integer
+    jit.reset();
+#endif
+    goto run_next_statement;
+}
+#endif
+
+#ifdef ENABLE_DATA
+read:
+    // READ var[, var...]  RESTORE [line]
+{
+    unsigned char op = mem.table_index;
+    VALUE value;
+    VALUE *var;
+    boolean to_fixed;
+
+    // RUN built the table, unless the program was started with GOTO
+    if (!data.built)
+    {
+        if (data.build())
+            goto warmstart;
+        if (!data.built)
+            goto qsorry;
+    }
+    if (op == KW_RESTORE)
+    {
+        value = 0;
+        if (*mem.txtpos != NL && *mem.txtpos != ':')
+        {
+            value = mem.expression();
+            if (mem.expression_error)
+                goto qwhat;
+            if (*mem.txtpos != NL && *mem.txtpos != ':')
+                goto qwhat;
+        }
+        data.restore(value);
+        goto run_next_statement;
+    }
+
+    while (1)
+    {
+        if (mem.isNotVariable())
+            goto qwhat;
+        var = mem.var(*mem.txtpos);
+        to_fixed = false;
+#ifdef ENABLE_FIXED
+        to_fixed = mem.is_fixed(*mem.txtpos);
+#endif
+        mem.txtpos++;
+#ifdef ENABLE_ARRAYS
+        if (*mem.txtpos == '(')
+        {
+            // array elements are integers
+            var = mem.element(mem.txtpos[-1]);
+            if (var == NULL)
+                goto qhow;
+            to_fixed = false;
+        }
+#endif
+        if (!data.read(&value))
+        {
+            IO.printmsg(nodatamsg);
+            goto stopped;
+        }
+#ifdef ENABLE_FIXED
+        // the items are integers
+        mem.expression_error = 0;
+        mem.fixed = 0;
+        value = mem.convert(value, to_fixed);
+        if (mem.expression_error)
+            goto qhow;
+#endif
+        *var = value;
+        mem.ignore_blanks();
+        if (*mem.txtpos != ',')
+            break;
+        mem.txtpos++;
+        mem.ignore_blanks();
+    }
+    if (*mem.txtpos != NL && *mem.txtpos != ':')
+        goto qwhat;
+    goto run_next_statement;
+}
+#endif
+
+sleep:
+    // SLEEP ms, DELAY ms
+    // timers keep running and their handlers are dispatched while we wait
+    val = mem.expression();
+    if (mem.expression_error)
+        goto qwhat;
+    if (val < 0)
+        goto qhow;
+    if (*mem.txtpos != NL && *mem.txtpos != ':')
+        goto qwhat;
+    timers.sleep(statement, val);
+
+sleep_wait:
+    while (!timers.awake())
+    {
+        // each pass idles, so the break key is looked for every time
+        if (IO.breakcheck(true))
+        {
+            IO.printmsg(breakmsg);
+            goto warmstart;
+        }
+        timers.check();
+        pins.check();
+        if (events.ready() && mem.current_line != NULL)
+        {
+            // the handler returns to this statement, which goes on sleeping
+            mem.txtpos = statement;
+            goto dispatch_event;
+        }
+        timers.idle();
+    }
+    goto run_next_statement;
+
 next:
     // Fnd the variable name
     mem.ignore_blanks();
-    if (mem.isNotAlpha())
+    if (mem.isNotVariable())
         goto qhow;
     mem.txtpos++;
     mem.ignore_blanks();
@@ -619,16 +1185,19 @@ next:
 gosub_return:
     // Now walk up the stack frames and find the frame we want, if present
     mem.tempsp = mem.sp;
-    while (mem.tempsp < mem.program + sizeof(mem.program) - 1)
+    while (mem.tempsp < mem.memory_end() - 1)
     {
         switch (mem.tempsp[0])
         {
+        case STACK_EVENT_FLAG:
         case STACK_GOSUB_FLAG:
             if (mem.table_index == KW_RETURN)
             {
                 struct stack_gosub_frame *f = (struct stack_gosub_frame *)mem.tempsp;
-                mem.current_line = f->current_line;
-                mem.txtpos = f->txtpos;
+                if (f->frame_type == STACK_EVENT_FLAG)
+                    events.busy = false;
+                mem.current_line = mem.pointer(f->current_line);
+                mem.txtpos = mem.pointer(f->txtpos);
                 mem.sp += sizeof(struct stack_gosub_frame);
                 goto run_next_statement;
             }
@@ -643,14 +1212,14 @@ gosub_return:
                 // Is the the variable we are looking for?
                 if (mem.txtpos[-1] == f->for_var)
                 {
-                    short int *varaddr = ((short int *)mem.variables_begin) + mem.txtpos[-1] - 'A';
+                    VALUE *varaddr = mem.var(mem.txtpos[-1]);
                     *varaddr = *varaddr + f->step;
                     // Use a different test depending on the sign of the step increment
                     if ((f->step > 0 && *varaddr <= f->terminal) || (f->step < 0 && *varaddr >= f->terminal))
                     {
                         // We have to loop so don't pop the stack
-                        mem.txtpos = f->txtpos;
-                        mem.current_line = f->current_line;
+                        mem.txtpos = mem.pointer(f->txtpos);
+                        mem.current_line = mem.pointer(f->current_line);
                         goto run_next_statement;
                     }
                     // We've run to the end of the loop. drop out of the loop, popping the stack
@@ -669,15 +1238,107 @@ gosub_return:
     // Didn't find the variable we've been looking for
     goto qhow;
 
+#ifdef ENABLE_FUSED
+run_fused:
+{
+    fused_line *f = fused.current;
+    VALUE *var = mem.var(f->var);
+
+    switch (f->kind)
+    {
+    case FUSED_ADD:
+#ifdef ENABLE_FIXED
+        // the constant is an integer
+        if (mem.is_fixed(f->var) || (f->other != 0 && mem.is_fixed(f->other)))
+            goto fused_fallback;
+#endif
+        if (f->other == 0)
+            *var = *var + f->value;
+        else if (f->value > 0)
+            *var = *var + *mem.var(f->other);
+        else
+            *var = *var - *mem.var(f->other);
+        break;
+
+    case FUSED_IF_GOTO:
+    {
+        VALUE val;
+        mem.txtpos = mem.current_line + f->start;
+        val = mem.typed_expression();
+        if (mem.expression_error || mem.txtpos != mem.current_line + f->end)
+            goto fused_fallback;
+        fused.fired[FUSED_IF_GOTO]++;
+        if (val == 0)
+            goto execnextline;
+        mem.current_line = mem.pointer(f->target);
+        goto execline;
+    }
+
+    case FUSED_NEXT:
+    {
+        // only the innermost loop, the others walk the stack
+        struct stack_for_frame *s = (struct stack_for_frame *)mem.sp;
+        if (mem.sp >= mem.memory_end() - 1 || s->frame_type != STACK_FOR_FLAG || s->for_var != f->var)
+            goto fused_fallback;
+        *var = *var + s->step;
+        if ((s->step > 0 && *var <= s->terminal) || (s->step < 0 && *var >= s->terminal))
+        {
+            fused.fired[FUSED_NEXT]++;
+            mem.txtpos = mem.pointer(s->txtpos);
+            mem.current_line = mem.pointer(s->current_line);
+            goto run_next_statement;
+        }
+        mem.sp += sizeof(struct stack_for_frame);
+        break;
+    }
+
+    case FUSED_PRINT:
+#ifdef ENABLE_FIXED
+        if (mem.is_fixed(f->var))
+            IO.printfixed(*var);
+        else
+#endif
+        IO.printnum(*var);
+        if (f->value)
+            IO.line_terminator();
+        break;
+    }
+    fused.fired[f->kind]++;
+    mem.txtpos = mem.current_line + f->end;
+    goto run_next_statement;
+
+fused_fallback:
+    fused.fallbacks++;
+    mem.txtpos = mem.current_line + LINE_HEADER;
+    goto unfused;
+}
+#endif
+
 assignment:
 {
-    short int value;
-    short int *var;
+    VALUE value;
+    VALUE *var;
+    boolean to_fixed = false;
 
-    if (mem.isNotAlpha())
+    if (mem.isNotVariable())
         goto qhow;
-    var = (short int *)mem.variables_begin + *mem.txtpos - 'A';
+    var = mem.var(*mem.txtpos);
+#ifdef ENABLE_FIXED
+    to_fixed = mem.is_fixed(*mem.txtpos);
+#endif
     mem.txtpos++;
+#ifdef ENABLE_ARRAYS
+    if (*mem.txtpos == '(')
+    {
+        // array elements are integers
+        var = mem.element(mem.txtpos[-1]);
+        if (var == NULL)
+            goto qhow;
+#ifdef ENABLE_FIXED
+        to_fixed = false;
+#endif
+    }
+#endif
 
     mem.ignore_blanks();
 
@@ -685,7 +1346,7 @@ assignment:
         goto qwhat;
     mem.txtpos++;
     mem.ignore_blanks();
-    value = mem.expression();
+    value = mem.expression_as(to_fixed);
     if (mem.expression_error)
         goto qwhat;
     // Check that we are at the end of the statement
@@ -696,7 +1357,7 @@ assignment:
     goto run_next_statement;
 poke:
 {
-    short int value;
+    VALUE value;
     unsigned char *address;
 
     // Work out where to put it
@@ -734,7 +1395,12 @@ list:
     // Find the line
     mem.list_line = mem.findline();
     while (mem.list_line != mem.program_end)
+    {
         IO.printline();
+#ifdef ENABLE_PAGING
+        mem.list_line = pager.follow(mem.list_line);
+#endif
+    }
     goto warmstart;
 
 print:
@@ -761,9 +1427,14 @@ print:
             goto qwhat;
         else
         {
-            short int e = mem.expression();
+            VALUE e = mem.typed_expression();
             if (mem.expression_error)
                 goto qwhat;
+#ifdef ENABLE_FIXED
+            if (mem.fixed)
+                IO.printfixed(e);
+            else
+#endif
             IO.printnum(e);
         }
 
@@ -789,42 +1460,57 @@ mem:
     // memory free
     IO.printnum(mem.free_mem());
     IO.printmsg(memorymsg);
-#ifdef ARDUINO
-#ifdef ENABLE_EEPROM
+    IO.printnum(mem.name_count);
+    IO.printmsgNoNL(ofmsg);
+    IO.printnum(kVarSlots);
+    IO.printmsg(namesmsg);
+#ifdef ENABLE_PAGING
+    if (pager.active)
     {
-        // eprom size
-        IO.printnum(E2END + 1);
-        IO.printmsg(eeprommsg);
-
-        // figure out the memory usage;
-        val = ' ';
-        int i;
-        for (i = 0; (i < (E2END + 1)) && (val != '\0'); i++)
-        {
-            val = EEPROM.read(i);
-        }
-        IO.printnum((E2END + 1) - (i - 1));
-
-        IO.printmsg(eepromamsg);
+        IO.printnum(pager.pages);
+        IO.printmsgNoNL(pagesmsg);
+        IO.printnum(pager.faults);
+        IO.printmsg(faultsmsg);
+    }
+#endif
+    if (mem.sample_room)
+    {
+        IO.printnum(mem.sample_room * sizeof(short int));
+        IO.printmsg(samplemsg);
     }
+#ifdef ENABLE_DATA
+    if (data.built && data.items_count())
+    {
+        IO.printnum(data.items_count());
+        IO.printmsgNoNL(datamsg);
+        IO.printnum(data.bytes());
+        IO.printmsg(databytesmsg);
+    }
+#endif
+#ifdef ENABLE_EEPROM
+    // eprom size, and what the stored program leaves of it
+    IO.printnum(EE_SIZE);
+    IO.printmsg(eeprommsg);
+    IO.printnum(EE_SIZE - EE_HEADER - estore.stored());
+    IO.printmsg(eepromamsg);
 #endif /* ENABLE_EEPROM */
-#endif /* ARDUINO */
     goto run_next_statement;
 
     /*************************************************/
 
-#ifdef ARDUINO
 awrite: // AWRITE <pin>,val
 dwrite:
 {
-    short int pinNo;
-    short int value;
+    VALUE pinNo;
+    VALUE value;
     unsigned char *txtposBak;
 
     // Get the pin number
     pinNo = mem.expression();
     if (mem.expression_error)
         goto qwhat;
+    if (!pins.valid(pinNo))
+        goto qhow;
 
     // check for a comma
     mem.ignore_blanks();
@@ -854,23 +1540,16 @@ dwrite:
         if (mem.expression_error)
             goto qwhat;
     }
-    pinMode(pinNo, OUTPUT);
     if (isDigital)
     {
-        digitalWrite(pinNo, value);
+        pins.dwrite(pinNo, value);
     }
     else
     {
-        analogWrite(pinNo, value);
+        pins.awrite(pinNo, value);
     }
 }
     goto run_next_statement;
-#else
-pinmode: // PINMODE <pin>, I/O
-awrite:  // AWRITE <pin>,val
-dwrite:
-    goto unimplemented;
-#endif
 
     /*************************************************/
 files:
@@ -878,7 +1557,8 @@ files:
     // version 1: no support for subdirectories
 
 #ifdef ENABLE_FILEIO
-    cmd_Files();
+    if (fileio.begin())
+        fileio.list();
     goto warmstart;
 #else
     goto unimplemented;
@@ -902,64 +1582,121 @@ load:
         if (mem.expression_error)
             goto qwhat;
 
-#ifdef ARDUINO
-        // Arduino specific
-        if (!SD.exists((char *)filename))
+        if (!fileio.begin())
         {
-            printmsg(sdfilemsg);
+            runAfterLoad = false;
+            goto stopped;
         }
-        else
+        if (!fileio.open_read((const char *)filename))
         {
-
-            fp = SD.open((const char *)filename);
-            inStream = kStreamFile;
-            inhibitOutput = true;
+            runAfterLoad = false;
+            IO.printmsg(sdfilemsg);
+            goto stopped;
         }
-#else   // ARDUINO
-            // Desktop specific
-#endif  // ARDUINO
+
         // this will kickstart a series of events to read in from the file.
+        IO.inStream = streamioClass::streamType::kStreamFile;
+        inhibitOutput = true;
     }
     goto warmstart;
 #else  // ENABLE_FILEIO
     goto unimplemented;
 #endif // ENABLE_FILEIO
 
+#ifdef ENABLE_PAGING
+page:
+    // run a program too large for the memory from a page file
+{
+    unsigned char *filename;
+
+    mem.program_reset();
+    mem.expression_error = 0;
+    filename = filenameWord();
+    if (mem.expression_error)
+        goto qwhat;
+    if (!fileio.begin() || !pager.load((const char *)filename))
+    {
+        mem.program_reset();
+        goto stopped;
+    }
+    goto warmstart;
+}
+#endif /* ENABLE_PAGING */
+
 save:
     // save from memory out to a file
 #ifdef ENABLE_FILEIO
 {
     unsigned char *filename;
+#ifdef ENABLE_MINIFY
+    boolean minified = false;
+    unsigned char *line;
+
+    // SAVE MIN "file": MIN and then a blank or a quote, so a file
+    // called MIN... is still saved as it is
+    filename = mem.txtpos;
+    mem.scantable(min_tab);
+    if (mem.table_index == 0 && (mem.txtpos > filename + 3 || *mem.txtpos == '"'))
+        minified = true;
+    else
+        mem.txtpos = filename;
+#endif
 
     // Work out the filename
     mem.expression_error = 0;
     filename = filenameWord();
     if (mem.expression_error)
         goto qwhat;
-
-#ifdef ARDUINO
-    // remove the old file if it exists
-    if (SD.exists((char *)filename))
+#ifdef ENABLE_MINIFY
+    if (minified)
     {
-        SD.remove((char *)filename);
+#ifdef ENABLE_PAGING
+        if (pager.active)
+            goto unimplemented;
+#endif
+        if (!minify.begin(mem.txtpos))
+            goto qsorry;
     }
+#endif
 
     // open the file, switch over to file output
-    fp = SD.open((const char *)filename, FILE_WRITE);
-    outStream = kStreamFile;
+    if (!fileio.begin())
+        goto stopped;
+    if (!fileio.open_write((const char *)filename))
+    {
+        IO.printmsg(sdfilemsg);
+        goto stopped;
+    }
+    IO.outStream = streamioClass::streamType::kStreamFile;
 
     // copied from "List"
-    list_line = mem.findline();
+    mem.list_line = mem.findline();
     while (mem.list_line != mem.program_end)
-        mem.printline();
-
-    // go back to standard output, close the file
-    outStream = kStreamSerial;
+    {
+#ifdef ENABLE_MINIFY
+        if (minified)
+        {
+            line = mem.list_line + LINE_LENGTH(mem.list_line);
+            mem.list_line = minify.line(mem.list_line);
+            if (mem.list_line != NULL)
+                IO.printline(true);
+            mem.list_line = line;
+            continue;
+        }
+#endif
+        IO.printline();
+#ifdef ENABLE_PAGING
+        mem.list_line = pager.follow(mem.list_line);
+#endif
+    }
 
-    fp.close();
-#else  // ARDUINO
-        // desktop
-#endif // ARDUINO
+    // go back to standard output, write out the buffer and close the file
+    IO.outStream = streamioClass::streamType::kStreamSerial;
+    if (!fileio.close())
+    {
+        IO.printmsg(sdfilemsg);
+        goto stopped;
+    }
     goto warmstart;
 }
 #else  // ENABLE_FILEIO
@@ -968,7 +1705,7 @@ save:
 
 rseed:
 {
-    short int value = mem.expression();
+    VALUE value = mem.expression();
     if (mem.expression_error)
         goto qwhat;
 
@@ -991,7 +1728,7 @@ tonegen:
     // if either are 0, tones turned off
 
     //Get the frequency
-    short int freq = mem.expression();
+    VALUE freq = mem.expression();
     if (mem.expression_error)
         goto qwhat;
 
@@ -1002,18 +1739,37 @@ tonegen:
     mem.ignore_blanks();
 
     //Get the duration
-    short int duration = mem.expression();
+    VALUE duration = mem.expression();
     if (mem.expression_error)
         goto qwhat;
 
     if (freq == 0 || duration == 0)
         goto tonestop;
+#if VALUE_BITS > 16
+    // the timer that ends the tone counts in 16 bits
+    if (duration > 65535)
+        goto qhow;
+#endif
+
+    if (alsoWait)
+    {
+        // TONEW waits for the end of the tone like a SLEEP;
+        // back from an event handler, the tone is already playing
+        alsoWait = false;
+        if (!timers.sleep(statement, duration))
+            goto sleep_wait;
+        alsoWait = true;
+    }
 
-    tone(kPiezoPin, freq, duration);
+    // the timer wheel stops the tone, unless it has no slot left
+    tone(kPiezoPin, freq);
+    pins.forget(kPiezoPin);
+    if (!timers.tone_end(duration))
+        tone(kPiezoPin, freq, duration);
     if (alsoWait)
     {
-        delay(duration);
         alsoWait = false;
+        goto sleep_wait;
     }
     goto run_next_statement;
 }
@@ -1085,120 +1841,21 @@ void setup()
 
     IO.printmsg(initmsg);
 
+#endif /* ARDUINO */
+
 #ifdef ENABLE_FILEIO
-    initSD();
+#ifdef ARDUINO
+    fileio.begin();
+#endif
 
 #ifdef ENABLE_AUTORUN
-    if (SD.exists(kAutorunFilename))
+    if (fileio.open_read(kAutorunFilename))
     {
-        program_end = program_start;
-        fp = SD.open(kAutorunFilename);
-        inStream = kStreamFile;
+        IO.inStream = streamioClass::streamType::kStreamFile;
         inhibitOutput = true;
         runAfterLoad = true;
     }
 #endif /* ENABLE_AUTORUN */
 
 #endif /* ENABLE_FILEIO */
-
-#ifdef ENABLE_EEPROM
-#ifdef ENABLE_EAUTORUN
-    // read the first byte of the eeprom. if it's a number, assume it's a program we can load
-    int val = EEPROM.read(0);
-    if (val >= '0' && val <= '9')
-    {
-        mem.program_end = mem.program_start;
-        IO.inStream = streamioClass::streamType::kStreamEEProm;
-        eepos = 0;
-        inhibitOutput = true;
-        runAfterLoad = true;
-    }
-#endif /* ENABLE_EAUTORUN */
-#endif /* ENABLE_EEPROM */
-
-#endif /* ARDUINO */
-}
-
-/***********************************************************/
-/* SD Card helpers */
-
-#if ARDUINO && ENABLE_FILEIO
-
-static int initSD(void)
-{
-    // if the card is already initialized, we just go with it.
-    // there is no support (yet?) for hot-swap of SD Cards. if you need to
-    // swap, pop the card, reset the arduino.)
-
-    if (sd_is_initialized == true)
-        return kSD_OK;
-
-    // due to the way the SD Library works, pin 10 always needs to be
-    // an output, even when your shield uses another line for CS
-    pinMode(10, OUTPUT); // change this to 53 on a mega
-
-    if (!SD.begin(kSD_CS))
-    {
-        // failed
-        printmsg(sderrormsg);
-        return kSD_Fail;
-    }
-    // success - quietly return 0
-    sd_is_initialized = true;
-
-    // and our file redirection flags
-    outStream = kStreamSerial;
-    inStream = kStreamSerial;
-    inhibitOutput = false;
-
-    return kSD_OK;
-}
-#endif
-
-#if ENABLE_FILEIO
-void cmd_Files(void)
-{
-    File dir = SD.open("/");
-    dir.seek(0);
-
-    while (true)
-    {
-        File entry = dir.openNextFile();
-        if (!entry)
-        {
-            entry.close();
-            break;
-        }
-
-        // common header
-        printmsgNoNL(indentmsg);
-        printmsgNoNL((const unsigned char *)entry.name());
-        if (entry.isDirectory())
-        {
-            printmsgNoNL(slashmsg);
-        }
-
-        if (entry.isDirectory())
-        {
-            // directory ending
-            for (int i = strlen(entry.name()); i < 16; i++)
-            {
-                printmsgNoNL(spacemsg);
-            }
-            printmsgNoNL(dirextmsg);
-        }
-        else
-        {
-            // file ending
-            for (int i = strlen(entry.name()); i < 17; i++)
-            {
-                printmsgNoNL(spacemsg);
-            }
-            printUnum(entry.size());
-        }
-        line_terminator();
-        entry.close();
-    }
-    dir.close();
 }
-#endif
@@ -0,0 +1,158 @@
+/// @file
+/// Integer arrays implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "arrays.h"
+
+#ifdef ENABLE_ARRAYS
+
+#ifndef ARDUINO
+#include <string.h>
+#endif
+
+void arrayClass::reset()
+{
+    first = NULL;
+    found = NULL;
+}
+
+array_header *arrayClass::dim(unsigned char var, unsigned short count)
+{
+    array_header *a;
+
+    if ((unsigned long)count * sizeof(VALUE) + sizeof(array_header) > mem.free_mem())
+        return NULL;
+    a = (array_header *)mem.heap_alloc(sizeof(array_header) + count * sizeof(VALUE));
+    if (a == NULL)
+        return NULL;
+    a->next = mem.offset((unsigned char *)first);
+    a->count = count;
+    a->var = var;
+    fill(a, 0);
+    first = a;
+    found = a;
+    return a;
+}
+
+array_header *arrayClass::find(unsigned char var)
+{
+    array_header *a;
+
+    if (found != NULL && found->var == var)
+        return found;
+    for (a = first; a != NULL; a = (array_header *)mem.pointer(a->next))
+    {
+        if (a->var == var)
+        {
+            found = a;
+            return a;
+        }
+    }
+    return NULL;
+}
+
+/**********************************************/
+// the bulk operations: keep the loops simple, so they vectorize
+
+void arrayClass::fill(array_header *a, VALUE value)
+{
+    VALUE *p = data(a);
+    unsigned short n = a->count;
+
+    for (unsigned short i = 0; i < n; i++)
+        p[i] = value;
+}
+
+void arrayClass::copy(array_header *dst, array_header *src)
+{
+    unsigned short n = dst->count < src->count ? dst->count : src->count;
+
+    memmove(data(dst), data(src), n * sizeof(VALUE));
+}
+
+void arrayClass::add(array_header *dst, array_header *src)
+{
+    VALUE *d = data(dst);
+    VALUE *s = data(src);
+    unsigned short n = dst->count < src->count ? dst->count : src->count;
+
+    for (unsigned short i = 0; i < n; i++)
+        d[i] += s[i];
+}
+
+void arrayClass::scale(array_header *a, VALUE mul, VALUE div)
+{
+    VALUE *p = data(a);
+    unsigned short n = a->count;
+
+    if (div == 1)
+    {
+        for (unsigned short i = 0; i < n; i++)
+            p[i] *= mul;
+    }
+    else
+    {
+        for (unsigned short i = 0; i < n; i++)
+            p[i] = (DVALUE)p[i] * mul / div;
+    }
+}
+
+VALUE arrayClass::sum(array_header *a)
+{
+    VALUE *p = data(a);
+    unsigned short n = a->count;
+    UVALUE s = 0;
+
+    for (unsigned short i = 0; i < n; i++)
+        s += p[i];
+    return (VALUE)s;
+}
+
+VALUE arrayClass::lowest(array_header *a)
+{
+    VALUE *p = data(a);
+    unsigned short n = a->count;
+    VALUE m = p[0];
+
+    for (unsigned short i = 1; i < n; i++)
+        m = p[i] < m ? p[i] : m;
+    return m;
+}
+
+VALUE arrayClass::highest(array_header *a)
+{
+    VALUE *p = data(a);
+    unsigned short n = a->count;
+    VALUE m = p[0];
+
+    for (unsigned short i = 1; i < n; i++)
+        m = p[i] > m ? p[i] : m;
+    return m;
+}
+
+#endif
@@ -0,0 +1,91 @@
+/// @file
+/// Integer arrays definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _ARRAYS_H_
+#define _ARRAYS_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+#ifdef ENABLE_ARRAYS
+
+struct array_header
+{
+    PROGOFF next;         // the array dimensioned before this one
+    unsigned short count; // elements, DIM A(n) has n+1 of them
+    unsigned char var;    // letter or name slot of the array
+};
+
+/// Integer arrays.
+/// DIM takes each array from the heap, below the variables, as one block:
+/// a header and then the elements.  The blocks are chained, and the array
+/// last looked up is remembered, so a loop over one array does not walk
+/// the chain.  They last until RUN or NEW give the heap back.
+/// The bulk operations are plain loops over the elements, which the
+/// desktop compiler turns into vector code.
+class arrayClass
+{
+private:
+    array_header *first; // the array dimensioned last
+    array_header *found; // the array looked up last
+
+public:
+    /** forget every array: the heap has been reset */
+    void reset();
+    /** DIM var(n): NULL if there is no room */
+    array_header *dim(unsigned char var, unsigned short count);
+    /** the array of a variable, NULL if it has not been dimensioned */
+    array_header *find(unsigned char var);
+    /** the elements of an array */
+    inline VALUE *data(array_header *a) { return (VALUE *)(a + 1); }
+
+    /** AFILL: every element set to value */
+    void fill(array_header *a, VALUE value);
+    /** ACOPY: the elements of src into dst, as many as the shorter has */
+    void copy(array_header *dst, array_header *src);
+    /** AADD: the elements of src added to those of dst */
+    void add(array_header *dst, array_header *src);
+    /** ASCALE: every element times mul, divided by div */
+    void scale(array_header *a, VALUE mul, VALUE div);
+    /** ASUM( a ), wrapping around like + does */
+    VALUE sum(array_header *a);
+    /** AMIN( a ) */
+    VALUE lowest(array_header *a);
+    /** AMAX( a ) */
+    VALUE highest(array_header *a);
+};
+
+extern arrayClass arrays;
+
+#endif
+#endif
@@ -0,0 +1,165 @@
+/// @file
+/// DATA table for READ and RESTORE implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "data.h"
+#include "keywords.h"
+#include "strings.h"
+#include "streamio.h"
+#include "pager.h"
+
+#ifdef ENABLE_DATA
+
+void dataClass::reset()
+{
+    built = false;
+}
+
+// how far scan() has got
+struct data_scan
+{
+    dataClass *self;
+    boolean fill;          // copy the items, else count them and check them
+    unsigned char *listed; // the last line put in lines
+};
+
+unsigned char *dataClass::statement(unsigned char *line, unsigned char *p, void *context)
+{
+    data_scan *state = (data_scan *)context;
+    dataClass *d = state->self;
+    unsigned char *q;
+    VALUE v;
+
+    if (mem.table_index != KW_DATA)
+        return p;
+    if (state->listed != line)
+    {
+        if (state->fill)
+        {
+            d->lines[d->line_count].line = *(LINENUM *)line;
+            d->lines[d->line_count].first = d->count;
+        }
+        d->line_count++;
+        state->listed = line;
+    }
+    // [+|-]number[, [+|-]number...] up to the end of the statement
+    while (1)
+    {
+        boolean minus = *p == '-';
+        if (*p == '-' || *p == '+')
+            p++;
+        while (*p == SPACE || *p == TAB)
+            p++;
+        q = mem.constant(p, &v);
+        if (q == NULL)
+            break;
+        if (state->fill)
+            d->items[d->count] = minus ? -v : v;
+        d->count++;
+        for (p = q; *p == SPACE || *p == TAB; p++)
+            ;
+        if (*p != ',')
+            break;
+        p++;
+        while (*p == SPACE || *p == TAB)
+            p++;
+    }
+    if (q == NULL || (*p != ':' && *p != NL))
+    {
+        if (!state->fill)
+        {
+            d->errors++;
+            IO.printnum(*(LINENUM *)line);
+            IO.printmsg(baddatamsg);
+        }
+        // on to the next statement
+        while (*p != ':' && *p != NL)
+            p++;
+    }
+    return p;
+}
+
+// walk the program: without fill count the items and the DATA lines and
+// report the errors, else copy them into the table
+void dataClass::scan(boolean fill)
+{
+    data_scan state = {this, fill, NULL};
+
+    count = 0;
+    line_count = 0;
+    mem.walk(statement, &state);
+}
+
+unsigned short dataClass::build()
+{
+    built = false;
+    next = 0;
+#ifdef ENABLE_PAGING
+    // only part of a paged program is in memory
+    if (pager.active)
+        return 0;
+#endif
+    errors = 0;
+    scan(false);
+    if (errors)
+        return errors;
+
+    // with no room for it READ and RESTORE are out of memory
+    lines = (data_line *)mem.heap_alloc(bytes());
+    if (lines == NULL)
+        return 0;
+    items = (VALUE *)(lines + line_count);
+    scan(true);
+    built = true;
+    return 0;
+}
+
+boolean dataClass::read(VALUE *v)
+{
+    if (next >= count)
+        return false;
+    *v = items[next++];
+    return true;
+}
+
+void dataClass::restore(LINENUM line)
+{
+    unsigned short low = 0, high = line_count;
+
+    while (low < high)
+    {
+        unsigned short mid = (low + high) / 2;
+        if (lines[mid].line < line)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    next = low < line_count ? lines[low].first : count;
+}
+
+#endif
@@ -0,0 +1,93 @@
+/// @file
+/// DATA table for READ and RESTORE definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _DATA_H_
+#define _DATA_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+#ifdef ENABLE_DATA
+
+struct data_line
+{
+    LINENUM line;         // a line with DATA
+    unsigned short first; // its first item in the table
+};
+
+/// The constants of the DATA statements, for READ and RESTORE.
+/// RUN walks the program once and copies every DATA item into a table
+/// in the heap, in program order, with the first item of each DATA line
+/// next to it.  READ takes the next item from the table, and RESTORE n
+/// moves to the first DATA line from n on, so neither looks at the text
+/// of the program.  A program started with GOTO gets its table at the
+/// first READ or RESTORE.  Entering a line or loading a program drops
+/// the table.
+class dataClass
+{
+private:
+    VALUE *items;      // in the heap
+    data_line *lines;  // in the heap
+    unsigned short count;
+    unsigned short line_count;
+    unsigned short next; // the item the next READ takes
+    unsigned short errors;
+
+    void scan(boolean fill);
+    /** a keyword met by scan(), see keyword_visitor */
+    static unsigned char *statement(unsigned char *line, unsigned char *p, void *context);
+
+public:
+    /** the table is in the heap */
+    boolean built;
+
+    /** forget the table: the program changed, or the heap was reset */
+    void reset();
+    /** check the DATA statements and build the table: the number of
+     *  errors, which have been printed.  With no room for the table,
+     *  or in paged mode, built stays false. */
+    unsigned short build();
+    /** the next item into v, false when there are none left */
+    boolean read(VALUE *v);
+    /** the next READ takes the first item of the first DATA line from
+     *  line on */
+    void restore(LINENUM line);
+    /** items in the table, and the bytes the table takes */
+    inline unsigned short items_count() { return count; }
+    inline unsigned short bytes() { return count * sizeof(VALUE) + line_count * sizeof(data_line); }
+};
+
+extern dataClass data;
+
+#endif
+#endif
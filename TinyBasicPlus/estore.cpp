@@ -0,0 +1,415 @@
+/// @file
+/// EEProm program store implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "estore.h"
+#include "usermem.h"
+#include "streamio.h"
+#include "minify.h"
+
+#ifdef ENABLE_EEPROM
+
+// the words that get a token: statements, functions and the words
+// inside statements.  Each group has its own range of tokens, so a new
+// word at the end of a table does not change the tokens of the others
+// and programs already stored still load.
+static const unsigned char *token_table(unsigned char n, unsigned char *first, unsigned char *last)
+{
+    switch (n)
+    {
+    case 0:
+        *first = EE_TOKEN_KEYWORD;
+        *last = EE_TOKEN_FUNC - 1;
+        return keywords;
+    case 1:
+        *first = EE_TOKEN_FUNC;
+        *last = EE_TOKEN_WORD - 1;
+        return func_tab;
+    case 2:
+        *first = EE_TOKEN_WORD;
+        *last = EE_ESCAPE - 1;
+        return to_tab;
+    // the other words follow on from TO
+    case 3:
+        return step_tab;
+    case 4:
+        return on_tab;
+    case 5:
+        return change_tab;
+    }
+    return NULL;
+}
+
+// the longest word at text that has a token, 0 if none.
+// Words of one letter are not worth a token.
+static unsigned char token_match(unsigned char *text, unsigned char *length)
+{
+    const unsigned char *table, *word;
+    unsigned char n, i, token = 0, last = 0, best = 0;
+
+    *length = 1;
+    for (n = 0; (table = token_table(n, &token, &last)) != NULL; n++)
+    {
+        while (pgm_read_byte(table) != 0 && token <= last)
+        {
+            word = table;
+            for (i = 0; (pgm_read_byte(table) & 0x7F) == text[i]; i++)
+                if (pgm_read_byte(table++) & 0x80)
+                {
+                    if (i + 1 > *length)
+                    {
+                        *length = i + 1;
+                        best = token;
+                    }
+                    break;
+                }
+            // skip to the next word
+            table = word;
+            while (!(pgm_read_byte(table++) & 0x80))
+                ;
+            token++;
+        }
+    }
+    return best;
+}
+
+// the spelling of a token, NULL if there is no such token
+static const unsigned char *token_word(unsigned char token)
+{
+    const unsigned char *table;
+    unsigned char n, t = 0, last = 0;
+
+    for (n = 0; (table = token_table(n, &t, &last)) != NULL; n++)
+        while (pgm_read_byte(table) != 0 && t <= last)
+        {
+            if (t++ == token)
+                return table;
+            while (!(pgm_read_byte(table++) & 0x80))
+                ;
+        }
+    return NULL;
+}
+
+void estoreClass::update(unsigned short addr, unsigned char b)
+{
+    if (EEPROM.read(addr) == b)
+        return;
+    EEPROM.write(addr, b);
+    writes++;
+}
+
+void estoreClass::crc_add(unsigned char b)
+{
+    // CRC-16/CCITT, bit by bit: there is no room for a table
+    crc ^= (unsigned short)b << 8;
+    for (unsigned char i = 0; i < 8; i++)
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+}
+
+unsigned short estoreClass::header_word(unsigned char at)
+{
+    return EEPROM.read(at) | (EEPROM.read(at + 1) << 8);
+}
+
+unsigned short estoreClass::stored()
+{
+    unsigned short i;
+
+    if (EEPROM.read(0) == EE_MAGIC)
+    {
+        i = header_word(2);
+        if (EEPROM.read(1) > EE_FORMAT_TOKEN || i > EE_SIZE - EE_HEADER)
+            return 0;
+        return i;
+    }
+
+    // older versions saved plain text up to a '\0', starting with a line number
+    if (EEPROM.read(0) < '0' || EEPROM.read(0) > '9')
+        return 0;
+    for (i = 0; i < EE_SIZE && EEPROM.read(i) != '\0'; i++)
+        ;
+    return i;
+}
+
+boolean estoreClass::valid()
+{
+    unsigned short i, n;
+
+    n = stored();
+    if (n == 0)
+        return false;
+    if (EEPROM.read(0) != EE_MAGIC)
+        return true;
+
+    crc = 0xFFFF;
+    for (i = 0; i < n; i++)
+        crc_add(EEPROM.read(EE_HEADER + i));
+    return crc == header_word(4);
+}
+
+void estoreClass::format()
+{
+    writes = 0;
+    for (unsigned short i = 0; i < EE_SIZE; i++)
+        update(i, 0);
+}
+
+void estoreClass::begin_write()
+{
+    pos = EE_HEADER;
+    length = 0;
+    crc = 0xFFFF;
+    overflow = false;
+    writes = 0;
+}
+
+void estoreClass::put(unsigned char c)
+{
+    if (pos == EE_SIZE)
+    {
+        overflow = true;
+        return;
+    }
+    update(pos++, c);
+    crc_add(c);
+    length++;
+}
+
+boolean estoreClass::end_write(unsigned char format)
+{
+    if (overflow)
+    {
+        // leave no half program behind to be autorun
+        update(0, 0);
+        return false;
+    }
+    update(0, EE_MAGIC);
+    update(1, format);
+    update(2, length & 0xFF);
+    update(3, length >> 8);
+    update(4, crc & 0xFF);
+    update(5, crc >> 8);
+    return true;
+}
+
+void estoreClass::put_line(unsigned char *line)
+{
+    unsigned char *text, *name, token, length;
+    unsigned char quote = 0;
+
+    put(line[0]);
+    put(line[1]);
+    text = line + LINE_HEADER;
+    while (*text != NL)
+    {
+        if (quote)
+        {
+            if (*text == quote)
+                quote = 0;
+        }
+        else if (*text == '"' || *text == '\'')
+            quote = *text;
+        else if (*text >= NAME_TOKEN)
+        {
+            // names are stored spelled out, and get their slots again on ELOAD
+            name = mem.names + (*text++ - NAME_TOKEN) * kNameLength;
+            for (length = 0; length < kNameLength && name[length] != 0; length++)
+                put(name[length]);
+            continue;
+        }
+        else if ((token = token_match(text, &length)) != 0)
+        {
+            put(token);
+            text += length;
+#ifdef ENABLE_EE_STRIPREM
+            // the REM stays, so the line is still there for GOTO
+            if (token == EE_TOKEN_KEYWORD + KW_REM)
+                while (*text != NL)
+                    text++;
+#endif
+            continue;
+        }
+        if (*text >= EE_TOKEN)
+            put(EE_ESCAPE);
+        put(*text++);
+    }
+    put(NL);
+}
+
+boolean estoreClass::save(boolean minified)
+{
+    unsigned char *line, *text;
+
+    begin_write();
+    for (line = mem.program_start; line != mem.program_end; line += LINE_LENGTH(line))
+    {
+        text = line;
+#ifdef ENABLE_MINIFY
+        if (minified && (text = minify.line(line)) == NULL)
+            continue;
+#else
+        (void)minified;
+#endif
+        put_line(text);
+    }
+    if (!end_write(EE_FORMAT_TOKEN))
+        return false;
+#ifndef ARDUINO
+    sim_event("esave", length, writes);
+#endif
+    return true;
+}
+
+// decode the line at pos into a program line at dest, if it fits below
+// limit; returns the end of the line, NULL if it did not fit
+unsigned char *estoreClass::get_line(unsigned char *dest, unsigned char *limit)
+{
+    unsigned char *text;
+    const unsigned char *word;
+    unsigned char c;
+
+    if (dest + LINE_HEADER >= limit)
+        return NULL;
+    dest[0] = EEPROM.read(pos++);
+    dest[1] = EEPROM.read(pos++);
+    text = dest + LINE_HEADER;
+    while (text < limit)
+    {
+        c = EEPROM.read(pos++);
+        if (c == EE_ESCAPE)
+            c = EEPROM.read(pos++);
+        else if (c >= EE_TOKEN)
+        {
+            word = token_word(c);
+            if (word == NULL)
+                return NULL;
+            do
+            {
+                if (text == limit)
+                    return NULL;
+                *text++ = pgm_read_byte(word) & 0x7F;
+            } while (!(pgm_read_byte(word++) & 0x80));
+            continue;
+        }
+        *text++ = c;
+        if (c == NL)
+        {
+#ifdef ALIGN_MEMORY
+            if (ALIGN_UP(text) != text)
+                text++;
+#endif
+            LINE_LENGTH(dest) = text - dest;
+            return text;
+        }
+    }
+    return NULL;
+}
+
+boolean estoreClass::load()
+{
+    unsigned char *line = mem.program_start;
+    unsigned char *next;
+
+    while (pos < EE_HEADER + length)
+    {
+        // keep the room getln needs for the next line typed in
+        next = get_line(line, mem.heap_begin - 2);
+        if (next == NULL || !mem.bind_names(line + LINE_HEADER))
+        {
+            mem.program_end = mem.program_start;
+            return false;
+        }
+
+        // the names took less room: work out the length again
+        for (next = line + LINE_HEADER; *next != NL; next++)
+            ;
+        next++;
+#ifdef ALIGN_MEMORY
+        if (ALIGN_UP(next) != next)
+            next++;
+#endif
+        LINE_LENGTH(line) = next - line;
+        line = next;
+    }
+    mem.program_end = line;
+#ifndef ARDUINO
+    sim_event("eload", length, line - mem.program_start);
+#endif
+    return true;
+}
+
+void estoreClass::list()
+{
+    unsigned char *line;
+    unsigned char *buffer = mem.program_end;
+
+    if (!tokenized())
+    {
+        int val;
+        while ((val = get()) >= 0)
+            IO.outchar_printable(val);
+        return;
+    }
+
+    // each line is decoded into the free memory, then printed from there
+    while (pos < EE_HEADER + length)
+    {
+        line = get_line(buffer, mem.heap_begin);
+        if (line == NULL)
+            return;
+        IO.printnum(*(LINENUM *)buffer);
+        IO.outchar(' ');
+        for (line = buffer + LINE_HEADER; *line != NL; line++)
+            IO.outchar_printable(*line);
+        IO.line_terminator();
+    }
+}
+
+boolean estoreClass::tokenized()
+{
+    return !legacy && EEPROM.read(1) == EE_FORMAT_TOKEN;
+}
+
+boolean estoreClass::begin_read()
+{
+    if (!valid())
+        return false;
+    legacy = EEPROM.read(0) != EE_MAGIC;
+    length = stored();
+    pos = legacy ? 0 : EE_HEADER;
+    return true;
+}
+
+int estoreClass::get()
+{
+    if (pos == length + (legacy ? 0 : EE_HEADER))
+        return -1;
+    return EEPROM.read(pos++);
+}
+
+#endif /* ENABLE_EEPROM */
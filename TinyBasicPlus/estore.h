@@ -0,0 +1,111 @@
+/// @file
+/// EEProm program store definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _ESTORE_H_
+#define _ESTORE_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+
+// layout of the EEProm: a small header, then the program
+#define EE_MAGIC     0xB5
+#define EE_FORMAT_TEXT 0 // the program as LIST prints it
+#define EE_FORMAT_TOKEN 1 // binary line numbers and keyword tokens
+#define EE_HEADER    6   // magic, format, length (2), checksum (2)
+
+#define EE_SIZE (E2END + 1)
+
+// tokenized lines: line number (2 bytes, low first), text, NL.
+// In the text a byte from 0x80 stands for a word, EE_ESCAPE for the
+// byte that follows it.  New keywords go at the end of their table.
+#define EE_TOKEN         0x80
+#define EE_TOKEN_KEYWORD 0x80 // statements
+#define EE_TOKEN_FUNC    0xC0 // functions
+#define EE_TOKEN_WORD    0xE0 // TO, STEP, ...
+#define EE_ESCAPE        0xFF
+
+/// Program storage in the EEProm.
+/// The header holds the length and a CRC of the stored program, so it
+/// is known at once how much is stored and whether it is intact.
+/// Writes skip the bytes that already hold the right value: an EEProm
+/// write takes about 3.3 ms on AVR and wears the cell out.
+/// ESAVE stores the program tokenized, which ELOAD decodes straight into
+/// the program memory; text images are still read back through the
+/// console input.
+class estoreClass
+{
+private:
+    unsigned short pos;    // next data byte to read or write
+    unsigned short length; // data bytes stored, or being stored
+    unsigned short crc;
+    boolean overflow;
+    boolean legacy; // program saved by an older version, '\0' terminated
+
+    void update(unsigned short addr, unsigned char b);
+    void crc_add(unsigned char b);
+    unsigned short header_word(unsigned char at);
+
+    void begin_write();
+    void put(unsigned char c);
+    boolean end_write(unsigned char format);
+    void put_line(unsigned char *line);
+    unsigned char *get_line(unsigned char *dest, unsigned char *limit);
+
+public:
+    /** bytes actually written by the last ESAVE or EFORMAT */
+    unsigned short writes;
+
+    /** data bytes of the stored program, 0 if there is none */
+    unsigned short stored();
+    /** true if a complete, undamaged program is stored */
+    boolean valid();
+    /** EFORMAT */
+    void format();
+
+    /** ESAVE, minified for ESAVE MIN: false if the program did not fit */
+    boolean save(boolean minified);
+
+    /** false if there is nothing valid to read */
+    boolean begin_read();
+    /** true if the stored program can be loaded with load() */
+    boolean tokenized();
+    /** ELOAD of a tokenized program: false if it did not fit */
+    boolean load();
+    /** ELIST */
+    void list();
+    /** next byte of a text image, -1 at the end */
+    int get();
+};
+
+extern estoreClass estore;
+
+#endif
@@ -0,0 +1,67 @@
+/// @file
+/// Event queue implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "events.h"
+
+void eventsClass::reset()
+{
+    head = 0;
+    count = 0;
+    busy = false;
+}
+
+boolean eventsClass::post(LINENUM line)
+{
+    unsigned char i;
+
+    // a handler already waiting will see this event as well
+    for (i = 0; i < count; i++)
+        if (queue[(head + i) % kEventQueue] == line)
+            return true;
+
+    if (count == kEventQueue)
+    {
+        overruns++;
+        return false;
+    }
+    queue[(head + count) % kEventQueue] = line;
+    count++;
+    return true;
+}
+
+LINENUM eventsClass::next()
+{
+    LINENUM line = queue[head];
+    head = (head + 1) % kEventQueue;
+    count--;
+#ifndef ARDUINO
+    sim_event("gosub", line, 0);
+#endif
+    return line;
+}
@@ -0,0 +1,69 @@
+/// @file
+/// Event queue definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _EVENTS_H_
+#define _EVENTS_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+/// Bounded queue of ON ... GOSUB handlers waiting to be dispatched.
+/// Events are posted by the timers (and other sources) and consumed
+/// by the interpreter at the next statement boundary.
+class eventsClass
+{
+private:
+    LINENUM queue[kEventQueue];
+    unsigned char head;
+
+public:
+    /** number of events waiting */
+    unsigned char count;
+    /** true while a handler is running: events are held until RETURN */
+    boolean busy;
+    /** events dropped because the queue was full */
+    unsigned short overruns;
+
+    /** drop every pending event */
+    void reset();
+    /** queue the handler at line, coalescing duplicates */
+    boolean post(LINENUM line);
+    /** pop the oldest handler */
+    LINENUM next();
+    /** true if an event can be dispatched now */
+    inline boolean ready() { return count != 0 && !busy; }
+};
+
+extern eventsClass events;
+
+#endif
@@ -0,0 +1,267 @@
+/// @file
+/// Buffered file stream implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "fileio.h"
+#include "streamio.h"
+#include "pinio.h"
+
+#ifdef ENABLE_FILEIO
+
+#ifndef ARDUINO
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+boolean fileioClass::begin()
+{
+#ifdef ARDUINO
+    // if the card is already initialized, we just go with it.
+    // there is no support (yet?) for hot-swap of SD Cards. if you need to
+    // swap, pop the card, reset the arduino.)
+    if (initialized)
+        return true;
+
+    // due to the way the SD Library works, pin 10 always needs to be
+    // an output, even when your shield uses another line for CS
+    pins.mode(10, OUTPUT); // change this to 53 on a mega
+
+    if (!SD.begin(kSD_CS))
+    {
+        IO.printmsg(sderrormsg);
+        return false;
+    }
+    initialized = true;
+#endif
+    return true;
+}
+
+boolean fileioClass::exists(const char *name)
+{
+#ifdef ARDUINO
+    return SD.exists((char *)name);
+#else
+    struct stat st;
+    return stat(name, &st) == 0 && S_ISREG(st.st_mode);
+#endif
+}
+
+boolean fileioClass::open_read(const char *name)
+{
+    if (!exists(name))
+        return false;
+#ifdef ARDUINO
+    fp = SD.open(name);
+    if (!fp)
+        return false;
+#else
+    fp = fopen(name, "rb");
+    if (fp == NULL)
+        return false;
+#endif
+    writing = false;
+    pos = filled = 0;
+    bytes = 0;
+    blocks = 0;
+    return true;
+}
+
+void fileioClass::fill()
+{
+    int n;
+
+#ifdef ARDUINO
+    n = fp.read(buffer, kFileBuffer);
+#else
+    n = fread(buffer, 1, kFileBuffer, fp);
+#endif
+    pos = 0;
+    filled = n > 0 ? n : 0;
+    blocks++;
+}
+
+int fileioClass::get()
+{
+    if (pos == filled)
+    {
+        fill();
+        if (filled == 0)
+            return -1;
+    }
+    bytes++;
+    return buffer[pos++];
+}
+
+boolean fileioClass::open_write(const char *name)
+{
+#ifdef ARDUINO
+    // FILE_WRITE appends, so remove the old file first
+    if (SD.exists((char *)name))
+        SD.remove((char *)name);
+    fp = SD.open(name, FILE_WRITE);
+    if (!fp)
+        return false;
+#else
+    fp = fopen(name, "wb");
+    if (fp == NULL)
+        return false;
+#endif
+    writing = true;
+    failed = false;
+    pos = 0;
+    bytes = 0;
+    blocks = 0;
+    return true;
+}
+
+boolean fileioClass::flush()
+{
+    unsigned short n = pos;
+
+    pos = 0;
+    if (n == 0)
+        return !failed;
+    blocks++;
+#ifdef ARDUINO
+    if (fp.write(buffer, n) != n)
+#else
+    if (fwrite(buffer, 1, n, fp) != n)
+#endif
+        failed = true;
+    return !failed;
+}
+
+void fileioClass::put(unsigned char c)
+{
+    buffer[pos++] = c;
+    bytes++;
+    if (pos == kFileBuffer)
+        flush();
+}
+
+boolean fileioClass::close()
+{
+    boolean ok = true;
+
+    // a full buffer written out by put() may have failed already
+    if (writing)
+        ok = flush();
+#ifdef ARDUINO
+    fp.close();
+#else
+    if (fp == NULL)
+        return false;
+    if (fclose(fp) != 0)
+        ok = false;
+    fp = NULL;
+    sim_event(writing ? "save" : "load", bytes, blocks);
+#endif
+    writing = false;
+    return ok;
+}
+
+void fileioClass::list()
+{
+#ifdef ARDUINO
+    File dir = SD.open("/");
+    dir.seek(0);
+
+    while (true)
+    {
+        File entry = dir.openNextFile();
+        if (!entry)
+        {
+            entry.close();
+            break;
+        }
+
+        // common header
+        IO.printmsgNoNL(indentmsg);
+        IO.printmsgNoNL((const unsigned char *)entry.name());
+        if (entry.isDirectory())
+        {
+            IO.printmsgNoNL(slashmsg);
+        }
+
+        if (entry.isDirectory())
+        {
+            // directory ending
+            for (int i = strlen(entry.name()); i < 16; i++)
+            {
+                IO.printmsgNoNL(spacemsg);
+            }
+            IO.printmsgNoNL(dirextmsg);
+        }
+        else
+        {
+            // file ending
+            for (int i = strlen(entry.name()); i < 17; i++)
+            {
+                IO.printmsgNoNL(spacemsg);
+            }
+            IO.printUnum(entry.size());
+        }
+        IO.line_terminator();
+        entry.close();
+    }
+    dir.close();
+#else
+    // the desktop lists the current directory, in the same layout
+    DIR *dir = opendir(".");
+    struct dirent *entry;
+    struct stat st;
+
+    if (dir == NULL)
+        return;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] == '.' || stat(entry->d_name, &st) != 0)
+            continue;
+        IO.printmsgNoNL(indentmsg);
+        IO.printmsgNoNL((const unsigned char *)entry->d_name);
+        if (S_ISDIR(st.st_mode))
+        {
+            IO.printmsgNoNL(slashmsg);
+            for (int i = strlen(entry->d_name); i < 16; i++)
+                IO.printmsgNoNL(spacemsg);
+            IO.printmsgNoNL(dirextmsg);
+        }
+        else
+        {
+            for (int i = strlen(entry->d_name); i < 17; i++)
+                IO.printmsgNoNL(spacemsg);
+            IO.printUnum(st.st_size);
+        }
+        IO.line_terminator();
+    }
+    closedir(dir);
+#endif
+}
+
+#endif /* ENABLE_FILEIO */
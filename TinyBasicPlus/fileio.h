@@ -0,0 +1,93 @@
+/// @file
+/// Buffered file stream definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _FILEIO_H_
+#define _FILEIO_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+
+#ifdef ENABLE_FILEIO
+
+/// The file behind LOAD, SAVE, CHAIN and the autorun, on the SD card or,
+/// on the desktop, in the current directory.
+/// Only one file is open at a time, for reading or for writing, and it
+/// moves through a buffer of kFileBuffer bytes: the SD card reads and
+/// writes whole sectors anyway, and a call per character costs far more
+/// than the character.
+class fileioClass
+{
+private:
+#ifdef ARDUINO
+    File fp;
+    boolean initialized;
+#else
+    FILE *fp;
+#endif
+    unsigned char buffer[kFileBuffer];
+    unsigned short pos;    // next byte in the buffer
+    unsigned short filled; // bytes in the buffer, when reading
+    boolean writing;
+    boolean failed;        // a write of the buffer did not go through
+    unsigned long bytes;   // moved since the file was opened
+    unsigned short blocks; // reads or writes of the device
+
+    void fill();
+    boolean flush();
+
+public:
+    /** start up the card: false, with a message, if there is none */
+    boolean begin();
+    boolean exists(const char *name);
+
+    /** LOAD: false if the file cannot be opened */
+    boolean open_read(const char *name);
+    /** next byte of the file, -1 at the end */
+    int get();
+
+    /** SAVE: an existing file is replaced */
+    boolean open_write(const char *name);
+    void put(unsigned char c);
+
+    /** write out what is left in the buffer: false if it or any
+        earlier write failed */
+    boolean close();
+
+    /** FILES */
+    void list();
+};
+
+extern fileioClass fileio;
+
+#endif /* ENABLE_FILEIO */
+
+#endif
@@ -0,0 +1,214 @@
+/// @file
+/// Fused handlers for common statements implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "fused.h"
+#include "keywords.h"
+
+#ifdef ENABLE_FUSED
+
+#include <string.h>
+
+static unsigned char *blanks(unsigned char *p)
+{
+    while (*p == SPACE || *p == TAB)
+        p++;
+    return p;
+}
+
+// a variable that is not an array, as expr4 reads it
+static boolean plain_var(unsigned char *p)
+{
+    if (p[1] == '(')
+        return false;
+    return *p >= NAME_TOKEN || (*p >= 'A' && *p <= 'Z' && (p[1] < 'A' || p[1] > 'Z'));
+}
+
+void fusedClass::reset()
+{
+    built = false;
+}
+
+void fusedClass::build()
+{
+    unsigned char *txtpos = mem.txtpos;
+    LINENUM linenum = mem.linenum;
+
+    for (unsigned short i = 0; i < kFusedLines; i++)
+        lines[i].line = PROGOFF_NULL;
+    count = 0;
+    for (unsigned char *line = mem.program_start; line != mem.program_end; line += LINE_LENGTH(line))
+        match(line);
+    built = true;
+
+    mem.txtpos = txtpos;
+    mem.linenum = linenum;
+}
+
+void fusedClass::match(unsigned char *line)
+{
+    fused_line f;
+    unsigned char *p = line + LINE_HEADER;
+
+    mem.txtpos = p;
+    mem.scantable(keywords);
+    f.other = 0;
+    f.value = 1;
+    switch (mem.table_index)
+    {
+    case KW_LET:
+    case KW_DEFAULT:
+        // V = V + k, with blanks where the assignment allows them
+        p = mem.txtpos;
+        if (!plain_var(p))
+            return;
+        f.kind = FUSED_ADD;
+        f.var = *p;
+        p = blanks(p + 1);
+        if (*p != '=')
+            return;
+        p = blanks(p + 1);
+        if (*p != f.var || !plain_var(p))
+            return;
+        p = blanks(p + 1);
+        if (*p == '-')
+            f.value = -1;
+        else if (*p != '+')
+            return;
+        p = blanks(p + 1);
+        if (plain_var(p))
+            f.other = *p++;
+        else
+        {
+            VALUE k;
+            p = mem.constant(p, &k);
+            if (p == NULL)
+                return;
+            f.value *= k;
+        }
+        p = blanks(p);
+        if (*p != NL && *p != ':')
+            return;
+        break;
+
+    case KW_IF:
+        // the expression may only read variables, so the handler can give
+        // it back to IF without doing anything twice
+        p = mem.txtpos;
+        f.kind = FUSED_IF_GOTO;
+        f.start = p - line;
+        while (!(p[0] == 'G' && p[1] == 'O' && p[2] == 'T' && p[3] == 'O'))
+        {
+            if (*p >= NAME_TOKEN || (*p >= 'A' && *p <= 'Z'))
+            {
+                if (!plain_var(p))
+                    return;
+            }
+            else if (!(*p >= '0' && *p <= '9') && (*p == 0 || !strchr(" \t+-*/()<>=!", *p)))
+                return;
+            p++;
+        }
+        if (p == line + f.start)
+            return;
+        f.end = p - line;
+        p = mem.constant(blanks(p + 4), &f.value);
+        if (p == NULL || *blanks(p) != NL)
+            return;
+        mem.linenum = f.value;
+        f.target = mem.offset(mem.findline());
+        p = line + f.end;
+        break;
+
+    case KW_NEXT:
+        p = mem.txtpos;
+        if (mem.isNotVariable())
+            return;
+        f.kind = FUSED_NEXT;
+        f.var = *p;
+        p = blanks(p + 1);
+        if (*p != NL && *p != ':')
+            return;
+        break;
+
+    case KW_PRINT:
+    case KW_QMARK:
+        p = mem.txtpos;
+        if (!plain_var(p))
+            return;
+        f.kind = FUSED_PRINT;
+        f.var = *p;
+        p = blanks(p + 1);
+        if (p[0] == ';' && (p[1] == NL || p[1] == ':'))
+        {
+            f.value = 0;
+            p++;
+        }
+        else if (*p != NL && *p != ':')
+            return;
+        break;
+
+    default:
+        return;
+    }
+    if (f.kind != FUSED_IF_GOTO)
+        f.end = p - line;
+
+    // into the table, unless it is full
+    f.line = mem.offset(line);
+    unsigned short h = (f.line * 40503u >> 4) & (kFusedLines - 1);
+    for (unsigned short i = 0; i < kFusedLines; i++, h = (h + 1) & (kFusedLines - 1))
+    {
+        if (lines[h].line == PROGOFF_NULL)
+        {
+            lines[h] = f;
+            count++;
+            return;
+        }
+    }
+}
+
+fused_line *fusedClass::find(unsigned char *line)
+{
+    if (!built)
+        build();
+    if (count == 0)
+        return NULL;
+
+    PROGOFF o = mem.offset(line);
+    unsigned short h = (o * 40503u >> 4) & (kFusedLines - 1);
+    for (unsigned short i = 0; i < kFusedLines; i++, h = (h + 1) & (kFusedLines - 1))
+    {
+        if (lines[h].line == o)
+            return current = &lines[h];
+        if (lines[h].line == PROGOFF_NULL)
+            return NULL;
+    }
+    return NULL;
+}
+
+#endif
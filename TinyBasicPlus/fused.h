@@ -0,0 +1,96 @@
+/// @file
+/// Fused handlers for common statements definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _FUSED_H_
+#define _FUSED_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+#ifdef ENABLE_FUSED
+
+// the statements that have a fused handler
+#define FUSED_ADD     0 // V=V+k, V=V-k, V=V+W, V=V-W
+#define FUSED_IF_GOTO 1 // IF expression GOTO n
+#define FUSED_NEXT    2 // NEXT V
+#define FUSED_PRINT   3 // PRINT V, PRINT V;
+#define FUSED_KINDS   4
+
+struct fused_line
+{
+    PROGOFF line;        // PROGOFF_NULL for a free entry
+    unsigned char kind;  // FUSED_...
+    unsigned char var;   // letter or name slot of V
+    unsigned char other; // W, or 0 when a constant is added
+    LINELEN start;       // where the IF expression starts in the line
+    LINELEN end;         // where the statement ends in the line
+    VALUE value;         // k, the sign of W, or 1 when PRINT ends the line
+    PROGOFF target;      // the line GOTO goes to
+};
+
+/// Fused handlers for the first statement of a line.
+/// The first time a program runs, each line is matched against a few
+/// patterns that make up most of the statements of a loop.  A matched
+/// line skips scantable and the expression parser: its handler works
+/// from what was taken out of the text, and GOTO does not look for its
+/// line.  When the handler finds things are not as it expects (an
+/// expression error, NEXT of a loop that is not the innermost) the
+/// statement is run the usual way.  Entering a line or loading a
+/// program matches the lines again.
+class fusedClass
+{
+private:
+    fused_line lines[kFusedLines];
+    boolean built; // lines matched since the program changed
+    unsigned short count;
+
+    void build();
+    void match(unsigned char *line);
+
+public:
+    /** the entry of the last find() */
+    fused_line *current;
+    /** times each fused handler ran, and times it gave up */
+    unsigned long fired[FUSED_KINDS];
+    unsigned long fallbacks;
+
+    /** forget the matched lines: the program changed */
+    void reset();
+    /** the fused statement at the start of a line, NULL if it has none */
+    fused_line *find(unsigned char *line);
+};
+
+extern fusedClass fused;
+
+#endif
+#endif
@@ -46,26 +46,59 @@ extern boolean triggerRun;
 
 
 
+// a place in the program memory, as an offset from its start: the stack
+// frames keep these rather than pointers, which take twice the room on
+// a 32 bit machine and four times on a 64 bit one.  The desktop memory
+// is sized when it starts, up to 1G (-M), so it always takes 32 bits.
+#if defined(ARDUINO) && kRamSize <= 65536
+typedef unsigned short PROGOFF;
+#else
+typedef uint32_t PROGOFF;
+#endif
+#define PROGOFF_NULL ((PROGOFF)~0) // a NULL pointer, direct mode
+
+// the value of a variable, an array element or an expression.  The
+// Arduino keeps 16 bits to save RAM; the desktop counts in native 32 bit
+// ints, or in 16 bits like the Arduino with make NARROW_VALUES=1.
+// UVALUE is the same width unsigned, for sums that wrap around, and
+// DVALUE is twice as wide, for a product before it is scaled.
+#if defined(ARDUINO) || defined(NARROW_VALUES)
+typedef short int VALUE;
+typedef unsigned short UVALUE;
+typedef long DVALUE;
+#define VALUE_BITS 16
+#else
+typedef int VALUE;
+typedef unsigned int UVALUE;
+typedef long long DVALUE;
+#define VALUE_BITS 32
+#endif
+
 struct stack_for_frame {
   char frame_type;
-  char for_var;
-  short int terminal;
-  short int step;
-  unsigned char *current_line;
-  unsigned char *txtpos;
+  unsigned char for_var;
+  VALUE terminal;
+  VALUE step;
+  PROGOFF current_line;
+  PROGOFF txtpos;
 };
 
 struct stack_gosub_frame {
   char frame_type;
-  unsigned char *current_line;
-  unsigned char *txtpos;
+  PROGOFF current_line;
+  PROGOFF txtpos;
 };
 
 #define STACK_GOSUB_FLAG 'G'
 #define STACK_FOR_FLAG 'F'
+#define STACK_EVENT_FLAG 'E' // GOSUB frame of an event handler
+
+#define STACK_SIZE (sizeof(struct stack_for_frame) * mem.stack_frames)
+#define VAR_SIZE sizeof(VALUE) // Size of variables in bytes
+#define VAR_COUNT (27 + kVarSlots)  // A to Z, a spare, then the named ones
 
-#define STACK_SIZE (sizeof(struct stack_for_frame)*5)
-#define VAR_SIZE sizeof(short int) // Size of variables in bytes
+// in a stored line a variable with a longer name is one byte: its slot
+#define NAME_TOKEN 0x80
 
 
 ////////////////////////////////////////////////////////////////////////////////
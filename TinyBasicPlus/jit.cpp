@@ -0,0 +1,366 @@
+/// @file
+/// Desktop x86-64 JIT for hot lines implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "jit.h"
+#include "keywords.h"
+#include "fused.h"
+
+#ifdef ENABLE_JIT
+
+#include <string.h>
+#include <sys/mman.h>
+
+// the code of a line is built in this order, with rdi pointing to the
+// variables: r8 keeps the stack pointer so a bail out from inside an
+// expression can drop what it pushed
+static const unsigned char prologue[] = {0x49, 0x89, 0xE0};         // mov r8, rsp
+static const unsigned char bail_stack[] = {0x4C, 0x89, 0xC4};       // mov rsp, r8
+static const unsigned char ret[] = {0xC3};                          // ret
+static const unsigned char line_done[] = {0x31, 0xC0, 0xC3};        // xor eax, eax; ret
+static const unsigned char push_rax[] = {0x50};                     // push rax
+static const unsigned char pop_operands[] = {0x89, 0xC1, 0x58};     // mov ecx, eax; pop rax
+static const unsigned char op_neg[] = {0xF7, 0xD8};                 // neg eax
+static const unsigned char op_add[] = {0x01, 0xC8};                 // add eax, ecx
+static const unsigned char op_sub[] = {0x29, 0xC8};                 // sub eax, ecx
+static const unsigned char op_mul[] = {0x0F, 0xAF, 0xC1};           // imul eax, ecx
+static const unsigned char div_check[] = {0x85, 0xC9, 0x75, 0x09};  // test ecx, ecx; jnz over the bail out
+static const unsigned char cmp[] = {0x39, 0xC8};                    // cmp eax, ecx
+static const unsigned char zero[] = {0x31, 0xC0};                   // xor eax, eax
+static const unsigned char if_check[] = {0x85, 0xC0, 0x75, 0x03};   // test eax, eax; jnz over the line done
+static const unsigned char load_imm[] = {0xB8};                     // mov eax, imm32
+
+// the variables are VALUEs: 16 bit ones are cut down after each operation
+#if VALUE_BITS == 16
+static const unsigned char to_value[] = {0x0F, 0xBF, 0xC0};         // movsx eax, ax
+static const unsigned char to_value_bytes = sizeof(to_value);
+static const unsigned char op_div[] = {0x99, 0xF7, 0xF9};           // cdq; idiv ecx
+static const unsigned char load_var[] = {0x0F, 0xBF, 0x87};         // movsx eax, word [rdi + disp32]
+static const unsigned char store_var[] = {0x66, 0x89, 0x87};        // mov word [rdi + disp32], ax
+#else
+static const unsigned char to_value[] = {0x90};                     // nop, never emitted
+static const unsigned char to_value_bytes = 0;                      // eax wraps around by itself
+// in 64 bits, where the smallest value divided by -1 does not trap
+static const unsigned char op_div[] = {0x48, 0x63, 0xC0, 0x48, 0x63, 0xC9,
+                                       0x48, 0x99, 0x48, 0xF7, 0xF9}; // movsxd rax, eax; movsxd rcx, ecx; cqo; idiv rcx
+static const unsigned char load_var[] = {0x8B, 0x87};               // mov eax, [rdi + disp32]
+static const unsigned char store_var[] = {0x89, 0x87};              // mov [rdi + disp32], eax
+#endif
+
+// setcc al, then movzx eax, al, in the order of relop_tab
+static const unsigned char setcc[] = {0x9D, 0x95, 0x9F, 0x94, 0x9E, 0x9C, 0x95};
+static const unsigned char bool_to_int[] = {0x0F, 0xB6, 0xC0};
+
+void jitClass::reset()
+{
+    for (unsigned short i = 0; i < kJitLines; i++)
+        lines[i].line = PROGOFF_NULL;
+    used = 0;
+    full = false;
+}
+
+jit_line *jitClass::entry(unsigned char *line)
+{
+    PROGOFF o = mem.offset(line);
+    unsigned short h = (o * 40503u >> 4) & (kJitLines - 1);
+
+    for (unsigned short i = 0; i < kJitLines; i++, h = (h + 1) & (kJitLines - 1))
+    {
+        if (lines[h].line == o)
+            return &lines[h];
+        if (lines[h].line == PROGOFF_NULL)
+        {
+            lines[h].line = o;
+            lines[h].count = 0;
+            lines[h].code = JIT_NONE;
+            return &lines[h];
+        }
+    }
+    return NULL; // every entry taken: the line stays interpreted
+}
+
+boolean jitClass::emit(const unsigned char *bytes, unsigned char n)
+{
+    if (used + n >= kJitBytes)
+    {
+        full = true;
+        return false;
+    }
+    memcpy(buffer + used, bytes, n);
+    used += n;
+    return true;
+}
+
+boolean jitClass::emit32(unsigned long v)
+{
+    unsigned char b[4] = {(unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16), (unsigned char)(v >> 24)};
+    return emit(b, 4);
+}
+
+// return to the interpreter at the statement being compiled
+boolean jitClass::emit_bail()
+{
+    return emit(load_imm, 1) && emit32(resume) && emit(ret, 1);
+}
+
+/**********************************************/
+// expressions: the grammar of usermemClass::expression(), the value in eax
+
+boolean jitClass::expr4()
+{
+    mem.ignore_blanks();
+
+    if (*mem.txtpos == '-')
+    {
+        mem.txtpos++;
+        return expr4() && emit(op_neg, 2) && emit(to_value, to_value_bytes);
+    }
+
+    if (*mem.txtpos >= '0' && *mem.txtpos <= '9')
+    {
+        VALUE a = 0;
+        if (*mem.txtpos == '0')
+            mem.txtpos++;
+        else
+        {
+            do
+            {
+                a = a * 10 + *mem.txtpos - '0';
+                mem.txtpos++;
+            } while (*mem.txtpos >= '0' && *mem.txtpos <= '9');
+        }
+#ifdef ENABLE_FIXED
+        // fixed point numbers stay with the interpreter
+        if (*mem.txtpos == '.')
+            return false;
+#endif
+        return emit(load_imm, 1) && emit32((long)a);
+    }
+
+    // a variable: arrays and functions stay with the interpreter
+    if (*mem.txtpos >= NAME_TOKEN || (*mem.txtpos >= 'A' && *mem.txtpos <= 'Z' && (mem.txtpos[1] < 'A' || mem.txtpos[1] > 'Z')))
+    {
+        if (mem.txtpos[1] == '(')
+            return false;
+#ifdef ENABLE_FIXED
+        if (mem.is_fixed(*mem.txtpos))
+            return false;
+#endif
+        unsigned long disp = (unsigned char *)mem.var(*mem.txtpos) - mem.variables_begin;
+        mem.txtpos++;
+        return emit(load_var, sizeof(load_var)) && emit32(disp);
+    }
+
+    if (*mem.txtpos == '(')
+    {
+        mem.txtpos++;
+        if (!expression() || *mem.txtpos != ')')
+            return false;
+        mem.txtpos++;
+        return true;
+    }
+    return false;
+}
+
+boolean jitClass::expr3()
+{
+    if (!expr4())
+        return false;
+    mem.ignore_blanks();
+
+    while (1)
+    {
+        if (*mem.txtpos == '*')
+        {
+            mem.txtpos++;
+            if (!emit(push_rax, 1) || !expr4() || !emit(pop_operands, 3) || !emit(op_mul, 3) || !emit(to_value, to_value_bytes))
+                return false;
+        }
+        else if (*mem.txtpos == '/')
+        {
+            // a division by zero goes back to the interpreter, which reports it
+            mem.txtpos++;
+            if (!emit(push_rax, 1) || !expr4() || !emit(pop_operands, 3) ||
+                !emit(div_check, 4) || !emit(bail_stack, 3) || !emit_bail() ||
+                !emit(op_div, sizeof(op_div)) || !emit(to_value, to_value_bytes))
+                return false;
+        }
+        else
+            return true;
+    }
+}
+
+boolean jitClass::expr2()
+{
+    if (*mem.txtpos == '-' || *mem.txtpos == '+')
+    {
+        if (!emit(zero, 2))
+            return false;
+    }
+    else if (!expr3())
+        return false;
+
+    while (1)
+    {
+        const unsigned char *op;
+        if (*mem.txtpos == '-')
+            op = op_sub;
+        else if (*mem.txtpos == '+')
+            op = op_add;
+        else
+            return true;
+        mem.txtpos++;
+        if (!emit(push_rax, 1) || !expr3() || !emit(pop_operands, 3) || !emit(op, 2) || !emit(to_value, to_value_bytes))
+            return false;
+    }
+}
+
+boolean jitClass::expression()
+{
+    unsigned char relop;
+
+    if (!expr2())
+        return false;
+    mem.scantable(relop_tab);
+    relop = mem.table_index;
+    if (relop == RELOP_UNKNOWN)
+        return true;
+    unsigned char set[3] = {0x0F, setcc[relop], 0xC0};
+    return emit(push_rax, 1) && expr2() && emit(pop_operands, 3) && emit(cmp, 2) &&
+           emit(set, 3) && emit(bool_to_int, 3);
+}
+
+/**********************************************/
+
+void jitClass::compile(jit_line *e, unsigned char *line)
+{
+    unsigned short start = used;
+    unsigned char *stmt;
+    boolean direct = true; // the statement right at txtpos: the first, or the one after IF
+
+    if (buffer == NULL)
+    {
+        void *p = mmap(NULL, kJitBytes, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            enabled = false;
+            return;
+        }
+        buffer = (unsigned char *)p;
+    }
+    if (full)
+        return;
+#ifdef ENABLE_FUSED
+    // IF ... GOTO runs faster fused, with the line it goes to looked up once
+    if (fused.find(line) != NULL && fused.current->kind == FUSED_IF_GOTO)
+    {
+        e->count = kJitThreshold;
+        return;
+    }
+#endif
+
+    mem.txtpos = line + LINE_HEADER;
+    if (!emit(prologue, 3))
+        goto failed;
+    while (1)
+    {
+        if (!direct)
+        {
+            while (*mem.txtpos == ':')
+                mem.txtpos++;
+            mem.ignore_blanks();
+            if (*mem.txtpos == NL)
+            {
+                if (!emit(line_done, 3))
+                    goto failed;
+                break;
+            }
+        }
+        direct = false;
+        stmt = mem.txtpos;
+        resume = stmt - line;
+        mem.scantable(keywords);
+
+        if (mem.table_index == KW_LET || mem.table_index == KW_DEFAULT)
+        {
+            // variable = expression
+            unsigned long disp;
+            if (mem.isNotVariable() || mem.txtpos[1] == '(')
+                goto interpret;
+#ifdef ENABLE_FIXED
+            if (mem.is_fixed(*mem.txtpos))
+                goto interpret;
+#endif
+            disp = (unsigned char *)mem.var(*mem.txtpos) - mem.variables_begin;
+            mem.txtpos++;
+            mem.ignore_blanks();
+            if (*mem.txtpos != '=')
+                goto interpret;
+            mem.txtpos++;
+            mem.ignore_blanks();
+            if (!expression())
+                goto interpret;
+            if (*mem.txtpos != NL && *mem.txtpos != ':')
+                goto interpret;
+            if (!emit(store_var, sizeof(store_var)) || !emit32(disp))
+                goto failed;
+        }
+        else if (mem.table_index == KW_IF)
+        {
+            // a false condition ends the line
+            if (!expression() || *mem.txtpos == NL)
+                goto interpret;
+            if (!emit(if_check, 4) || !emit(line_done, 3))
+                goto failed;
+            direct = true;
+        }
+        else
+            goto interpret;
+        continue;
+
+    interpret:
+        // nothing compiled: leave the line to the interpreter for good
+        if (resume == LINE_HEADER)
+        {
+            used = start;
+            e->count = kJitThreshold;
+            return;
+        }
+        if (!emit_bail())
+            goto failed;
+        break;
+    }
+    e->code = start;
+    compiled++;
+    return;
+
+failed:
+    used = start;
+}
+
+#endif
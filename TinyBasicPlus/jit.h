@@ -0,0 +1,113 @@
+/// @file
+/// Desktop x86-64 JIT for hot lines definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _JIT_H_
+#define _JIT_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+#ifdef ENABLE_JIT
+
+// what a compiled line returns when it ran to the end
+#define JIT_LINE_DONE 0
+
+typedef LINELEN (*jit_code)(VALUE *variables);
+
+struct jit_line
+{
+    PROGOFF line;          // PROGOFF_NULL for a free entry
+    unsigned short count;  // times the line was started
+    unsigned short code;   // offset in the code buffer, JIT_NONE if not compiled
+};
+
+#define JIT_NONE 0xFFFF
+
+/// Tier-up compiler for hot lines, desktop x86-64 only.
+/// execline counts how many times each line starts; at kJitThreshold
+/// the assignments and IFs at the start of the line are compiled to
+/// machine code working on the variables in place.  The code runs up to
+/// the first statement it does not handle (GOTO, NEXT, PRINT, a function
+/// call...) or an error such as a division by zero, and returns where
+/// the interpreter goes on, so a line can be partly compiled.  Break,
+/// timers and events are checked by the interpreter between lines.
+/// Editing the program throws all the code away.
+class jitClass
+{
+private:
+    jit_line lines[kJitLines];
+    unsigned char *buffer; // kJitBytes, writable and executable
+    unsigned short used;
+    boolean full;          // out of room in the code buffer
+    unsigned short resume; // where the statement being compiled starts
+
+    jit_line *entry(unsigned char *line);
+    void compile(jit_line *e, unsigned char *line);
+    boolean emit(const unsigned char *bytes, unsigned char n);
+    boolean emit32(unsigned long v);
+    boolean emit_bail();
+    boolean expr4();
+    boolean expr3();
+    boolean expr2();
+    boolean expression();
+
+public:
+    /** off for debugging: -J on the command line */
+    boolean enabled = true;
+    /** lines compiled since the start */
+    unsigned long compiled;
+
+    /** forget every compiled line: the program changed */
+    void reset();
+
+    /** run the compiled code of the line, if it is hot enough.  Returns
+     *  the offset in the line where the interpreter goes on, or
+     *  JIT_LINE_DONE when the whole line ran */
+    inline LINELEN run(unsigned char *line)
+    {
+        jit_line *e;
+
+        if (!enabled || (e = entry(line)) == NULL)
+            return LINE_HEADER;
+        if (e->code != JIT_NONE)
+            return ((jit_code)(buffer + e->code))((VALUE *)mem.variables_begin);
+        if (e->count < kJitThreshold && ++e->count == kJitThreshold)
+            compile(e, line);
+        return LINE_HEADER;
+    }
+};
+
+extern jitClass jit;
+
+#endif
+#endif
@@ -34,7 +34,10 @@
 #include "platform.h"
 
 /***********************************************************/
-// Keyword table and constants - the last character has 0x80 added to it
+// Keyword table and constants - the last character has 0x80 added to it.
+// Every word is there whatever the build options: its index is also its
+// EEProm token (estore.cpp), so a program ESAVEd by one build ELOADs in
+// any other.  A statement left out of the build stops as unimplemented.
 const static unsigned char keywords[] PROGMEM = {
   'L','I','S','T'+0x80,
   'L','O','A','D'+0x80,
@@ -64,20 +67,27 @@ const static unsigned char keywords[] PROGMEM = {
   'E','N','D'+0x80,
   'R','S','E','E','D'+0x80,
   'C','H','A','I','N'+0x80,
-#ifdef ENABLE_TONES
+  'S','L','E','E','P'+0x80,
+  'O','N'+0x80,
+  'S','A','M','P','L','E'+0x80,
   'T','O','N','E','W'+0x80,
   'T','O','N','E'+0x80,
   'N','O','T','O','N','E'+0x80,
-#endif
-#ifdef ARDUINO
-#ifdef ENABLE_EEPROM
   'E','C','H','A','I','N'+0x80,
   'E','L','I','S','T'+0x80,
   'E','L','O','A','D'+0x80,
   'E','F','O','R','M','A','T'+0x80,
   'E','S','A','V','E'+0x80,
-#endif
-#endif
+  'P','A','G','E'+0x80,
+  'D','I','M'+0x80,
+  'A','F','I','L','L'+0x80,
+  'A','C','O','P','Y'+0x80,
+  'A','A','D','D'+0x80,
+  'A','S','C','A','L','E'+0x80,
+  'F','I','X','E','D'+0x80,
+  'D','A','T','A'+0x80,
+  'R','E','A','D'+0x80,
+  'R','E','S','T','O','R','E'+0x80,
   0
 };
 
@@ -101,14 +111,15 @@ enum {
   KW_END,
   KW_RSEED,
   KW_CHAIN,
-#ifdef ENABLE_TONES
+  KW_SLEEP,
+  KW_ON,
+  KW_SAMPLE,
   KW_TONEW, KW_TONE, KW_NOTONE,
-#endif
-#ifdef ARDUINO
-#ifdef ENABLE_EEPROM
-  KW_ECHAIN, KW_ELIST, KW_ELOAD, KW_EFORMAT, KW_ESAVE, 
-#endif
-#endif
+  KW_ECHAIN, KW_ELIST, KW_ELOAD, KW_EFORMAT, KW_ESAVE,
+  KW_PAGE,
+  KW_DIM, KW_AFILL, KW_ACOPY, KW_AADD, KW_ASCALE,
+  KW_FIXED,
+  KW_DATA, KW_READ, KW_RESTORE,
   KW_DEFAULT /* always the final one*/
 };
 
@@ -121,6 +132,12 @@ const static unsigned char func_tab[] PROGMEM = {
   'D','R','E','A','D'+0x80,
   'R','N','D'+0x80,
   'S','G','N'+0x80,
+  'M','I','L','L','I','S'+0x80,
+  'S','A','M','P','L','E'+0x80,
+  'S','C','O','U','N','T'+0x80,
+  'A','S','U','M'+0x80,
+  'A','M','I','N'+0x80,
+  'A','M','A','X'+0x80,
   0
 };
 
@@ -131,6 +148,12 @@ enum {
     FUNC_DREAD   ,
     FUNC_RND     ,
     FUNC_SGN     ,
+    FUNC_MILLIS  ,
+    FUNC_SAMPLE  ,
+    FUNC_SCOUNT  ,
+    FUNC_ASUM    ,
+    FUNC_AMIN    ,
+    FUNC_AMAX    ,
     FUNC_UNKNOWN 
 };
 
@@ -144,6 +167,32 @@ const static unsigned char step_tab[] PROGMEM = {
   0
 };
 
+// SAVE MIN and ESAVE MIN (see ENABLE_MINIFY)
+const static unsigned char min_tab[] PROGMEM = {
+  'M','I','N'+0x80,
+  0
+};
+
+const static unsigned char on_tab[] PROGMEM = {
+  'T','I','M','E','R'+0x80,
+  'P','I','N'+0x80,
+  0
+};
+
+#define ON_TIMER    0
+#define ON_PIN      1
+#define ON_UNKNOWN  2
+
+const static unsigned char change_tab[] PROGMEM = {
+  'C','H','A','N','G','E'+0x80,
+  0
+};
+
+const static unsigned char gosub_tab[] PROGMEM = {
+  'G','O','S','U','B'+0x80,
+  0
+};
+
 const static unsigned char relop_tab[] PROGMEM = {
   '>','='+0x80,
   '<','>'+0x80,
@@ -0,0 +1,215 @@
+/// @file
+/// Link pass before RUN implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "link.h"
+#include "keywords.h"
+#include "strings.h"
+#include "streamio.h"
+#include "pager.h"
+
+#ifdef ENABLE_LINK
+
+// FOR and NEXT of a variable, as the scan goes down the program
+#define LINK_NO_FOR 0      // no FOR yet
+#define LINK_CLOSED 0xFFFF // every FOR so far has a NEXT below it
+
+void linkClass::reset()
+{
+    linked = false;
+}
+
+// how far a walk of the program has got
+struct link_scan
+{
+    linkClass *self;
+    link_jump *fill;       // keep the constant jumps here
+    unsigned short n;      // constant jumps so far
+    boolean check;         // report the errors
+    LINENUM find;          // jumps_to(): the line looked for
+    boolean found;         // a jump to it, or a computed one
+    LINENUM open[VAR_COUNT]; // line of the FOR still waiting for its NEXT
+};
+
+unsigned char *linkClass::statement(unsigned char *line, unsigned char *p, void *context)
+{
+    link_scan *state = (link_scan *)context;
+    LINENUM num = *(LINENUM *)line;
+    unsigned char *q;
+
+    if (mem.table_index == KW_GOTO || mem.table_index == KW_GOSUB)
+    {
+        // only a constant line number, alone up to the end of the line
+        VALUE target;
+        q = mem.constant(p, &target);
+        if (q != NULL)
+            while (*q == SPACE || *q == TAB)
+                q++;
+        if (q == NULL || *q != NL)
+        {
+            // a computed one may go anywhere
+            state->found = true;
+            return p;
+        }
+        if (target == 0) // ON ... GOSUB 0 stops the handler
+            return p;
+        if (state->fill == NULL && !state->check)
+        {
+            // jumps_to()
+            if ((LINENUM)target != state->find)
+                return p;
+            state->found = true;
+            return NULL;
+        }
+        mem.linenum = target;
+        q = mem.findline();
+        if (q == mem.program_end || *(LINENUM *)q != mem.linenum)
+        {
+            if (state->check)
+            {
+                state->self->errors++;
+                IO.printnum(num);
+                IO.printmsgNoNL(nolinemsg);
+                IO.printnum(mem.linenum);
+                IO.line_terminator();
+            }
+            return p;
+        }
+        if (state->fill != NULL)
+        {
+            state->fill[state->n].at = mem.offset(p);
+            state->fill[state->n].target = mem.offset(q);
+        }
+        state->n++;
+    }
+    else if ((mem.table_index == KW_FOR || mem.table_index == KW_NEXT) && state->check)
+    {
+        if (mem.isNotVariable())
+            return p;
+        unsigned short v = mem.var(*p) - (VALUE *)mem.variables_begin;
+        if (mem.table_index == KW_FOR)
+            state->open[v] = num;
+        else if (state->open[v] == LINK_NO_FOR)
+        {
+            state->self->errors++;
+            IO.printnum(num);
+            IO.printmsg(noformsg);
+        }
+        else
+            state->open[v] = LINK_CLOSED;
+    }
+    return p;
+}
+
+// walk the program: with fill NULL count the constant jumps and report
+// the errors, else keep the jumps in fill
+unsigned short linkClass::scan(link_jump *fill)
+{
+    link_scan state;
+
+    state.self = this;
+    state.fill = fill;
+    state.n = 0;
+    state.check = fill == NULL;
+    state.found = false;
+    for (unsigned short v = 0; v < VAR_COUNT; v++)
+        state.open[v] = LINK_NO_FOR;
+    mem.walk(statement, &state);
+
+    if (state.check)
+    {
+        for (unsigned short v = 0; v < VAR_COUNT; v++)
+        {
+            if (state.open[v] != LINK_NO_FOR && state.open[v] != LINK_CLOSED)
+            {
+                errors++;
+                IO.printnum(state.open[v]);
+                IO.printmsg(nonextmsg);
+            }
+        }
+    }
+    return state.n;
+}
+
+boolean linkClass::jumps_to(LINENUM line)
+{
+    link_scan state;
+
+    state.self = this;
+    state.fill = NULL;
+    state.n = 0;
+    state.check = false;
+    state.find = line;
+    state.found = false;
+    mem.walk(statement, &state);
+    return state.found;
+}
+
+unsigned short linkClass::link()
+{
+    linked = false;
+#ifdef ENABLE_PAGING
+    // only part of a paged program is in memory
+    if (pager.active)
+        return 0;
+#endif
+    errors = 0;
+    count = scan(NULL);
+    if (errors)
+        return errors;
+
+    // with no room for them the jumps look for their lines
+    jumps = (link_jump *)mem.heap_alloc(count * sizeof(link_jump));
+    if (jumps == NULL)
+        return 0;
+    scan(jumps);
+    linked = true;
+    return 0;
+}
+
+unsigned char *linkClass::target(unsigned char *txtpos)
+{
+    PROGOFF at = mem.offset(txtpos);
+    unsigned short low = 0, high = count;
+
+    if (!linked)
+        return NULL;
+    while (low < high)
+    {
+        unsigned short mid = (low + high) / 2;
+        if (jumps[mid].at < at)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low < count && jumps[low].at == at)
+        return mem.pointer(jumps[low].target);
+    return NULL;
+}
+
+#endif
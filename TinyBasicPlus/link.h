@@ -0,0 +1,87 @@
+/// @file
+/// Link pass before RUN definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _LINK_H_
+#define _LINK_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+#ifdef ENABLE_LINK
+
+struct link_jump
+{
+    PROGOFF at;     // the line number after GOTO or GOSUB
+    PROGOFF target; // the line it names
+};
+
+/// Link pass run by RUN.
+/// It walks the program once before it starts, and reports every
+/// GOTO or GOSUB to a line that is not there, every NEXT with no FOR
+/// for its variable above it and every FOR with no NEXT below it.
+/// A program with errors does not run.  The lines that GOTO and GOSUB
+/// with a constant line number go to are kept in the heap, in program
+/// order, so those jumps do not have to look for their line.  A jump
+/// with an expression still does.  Entering a line or loading a program
+/// drops what was linked.
+class linkClass
+{
+private:
+    link_jump *jumps; // in the heap
+    unsigned short count;
+    unsigned short errors;
+    boolean linked;
+
+    unsigned short scan(link_jump *fill);
+    /** a keyword met by a walk of the program, see keyword_visitor */
+    static unsigned char *statement(unsigned char *line, unsigned char *p, void *context);
+
+public:
+    /** forget the linked jumps: the program changed, or the heap was reset */
+    void reset();
+    /** check and link the program: the number of errors, which have
+     *  been printed */
+    unsigned short link();
+    /** the line a GOTO or GOSUB with its line number at txtpos goes to,
+     *  NULL if it was not linked */
+    unsigned char *target(unsigned char *txtpos);
+    /** without linking: true if a GOTO or GOSUB goes to line, or if
+     *  one has a line number that is not a constant.  jumps_to(0) only
+     *  looks for the computed ones. */
+    boolean jumps_to(LINENUM line);
+};
+
+extern linkClass linker;
+
+#endif
+#endif
@@ -0,0 +1,142 @@
+/// @file
+/// Minified SAVE and ESAVE implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "minify.h"
+#include "keywords.h"
+#include "link.h"
+
+#ifdef ENABLE_MINIFY
+
+static boolean isWordChar(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= NAME_TOKEN;
+}
+
+boolean minifyClass::begin(unsigned char *used)
+{
+    unsigned char *line;
+    PROGOFF longest = 0;
+
+    computed = linker.jumps_to(0);
+
+    for (line = mem.program_start; line != mem.program_end; line += LINE_LENGTH(line))
+        if (LINE_LENGTH(line) > longest)
+            longest = LINE_LENGTH(line);
+    // a direct command is typed in above the program, and is still read
+    buffer = used >= mem.program_end ? used + 1 : mem.program_end;
+    return buffer + longest <= mem.heap_begin;
+}
+
+unsigned char *minifyClass::line(unsigned char *line)
+{
+    unsigned char *p = line + LINE_HEADER;
+    unsigned char *text = buffer + LINE_HEADER;
+    unsigned char *to = text;
+    unsigned char *statement = text; // where the statement starts, after its ':'
+    unsigned char *txtpos = mem.txtpos;
+    unsigned char comment = 0; // the REM or ' of a comment
+    unsigned char run = 0;     // bytes of the first word of the statement
+    boolean blank = false;     // blanks left out before p
+
+    while (*p != NL)
+    {
+        if (*p == SPACE || *p == TAB)
+        {
+            blank = true;
+            p++;
+            continue;
+        }
+        if (to == statement)
+        {
+            // a comment goes, with the ':' before it
+            mem.txtpos = p;
+            mem.scantable(keywords);
+            if (mem.table_index == KW_REM || mem.table_index == KW_QUOTE)
+            {
+                comment = *p;
+                to = statement == text ? text : statement - 1;
+                break;
+            }
+        }
+        // a blank stays between two words, and before the = of a
+        // statement that is one word so far, which the blank keeps from
+        // being read as a longer name: FORAB = 1 is FOR AB = 1
+        if (blank && to != statement && isWordChar(to[-1])
+            && (isWordChar(*p) || (*p == '=' && run > 1 && run != 0xFF)))
+        {
+            *to++ = SPACE;
+            run = 0xFF;
+        }
+        blank = false;
+        if (*p == '"' || *p == '\'')
+        {
+            // a string stays as it is
+            unsigned char quote = *p;
+            do
+                *to++ = *p++;
+            while (*p != quote && *p != NL);
+            if (*p == quote)
+                *to++ = *p++;
+            run = 0xFF;
+            continue;
+        }
+        if (*p == ':')
+        {
+            *to++ = *p++;
+            statement = to;
+            run = 0;
+            continue;
+        }
+        if (run != 0xFF)
+            run = isWordChar(*p) ? run + 1 : 0xFF;
+        *to++ = *p++;
+    }
+    mem.txtpos = txtpos;
+
+    if (to == text)
+    {
+        // only a comment: the line goes, unless a jump could go to it
+        if (!computed && !linker.jumps_to(*(LINENUM *)line))
+            return NULL;
+        if (comment == '\'')
+            *to++ = '\'';
+        else
+        {
+            *to++ = 'R';
+            *to++ = 'E';
+            *to++ = 'M';
+        }
+    }
+    *to++ = NL;
+    *(LINENUM *)buffer = *(LINENUM *)line;
+    LINE_LENGTH(buffer) = to - buffer;
+    return buffer;
+}
+
+#endif
@@ -0,0 +1,66 @@
+/// @file
+/// Minified SAVE and ESAVE definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _MINIFY_H_
+#define _MINIFY_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+#ifdef ENABLE_MINIFY
+
+/// The lines of the program as SAVE MIN and ESAVE MIN store them.
+/// REM and ' comments are left out, with the ':' before them, and so
+/// are the blanks that do not keep two words apart.  A line that is
+/// only a comment is left out too, unless a GOTO or GOSUB names it:
+/// then a bare REM keeps it there.  When a jump has a computed line
+/// number, which could be any line, no line is left out.
+class minifyClass
+{
+private:
+    unsigned char *buffer; // a minified line, in the free memory
+    boolean computed;      // a GOTO or GOSUB with an expression
+
+public:
+    /** look at the jumps of the program, and put the buffer above
+     *  used: false if there is no room for the longest line */
+    boolean begin(unsigned char *used);
+    /** the line minified, with its header, in the buffer: NULL if it
+     *  is left out */
+    unsigned char *line(unsigned char *line);
+};
+
+extern minifyClass minify;
+
+#endif
+#endif
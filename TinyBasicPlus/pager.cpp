@@ -0,0 +1,293 @@
+/// @file
+/// Paged program storage implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "pager.h"
+#include "fileio.h"
+#include "streamio.h"
+
+#ifdef ENABLE_PAGING
+
+#ifndef ARDUINO
+#include <string.h>
+#endif
+
+boolean pagerClass::load(const char *name)
+{
+    unsigned char *page = mem.program_start; // slot 0 puts the pages together
+    unsigned char *line;
+    unsigned short fill = 0, n;
+    LINENUM last = 0;
+    int c = 0;
+
+    stop();
+    if (!fileio.open_read(name))
+    {
+        IO.printmsg(sdfilemsg);
+        return false;
+    }
+#ifdef ARDUINO
+    if (SD.exists((char *)kPageFilename))
+        SD.remove((char *)kPageFilename);
+    fp = SD.open(kPageFilename, FILE_WRITE);
+    if (!fp)
+#else
+    fp = fopen(kPageFilename, "w+b");
+    if (fp == NULL)
+#endif
+    {
+        fileio.close();
+        IO.printmsg(sdfilemsg);
+        return false;
+    }
+
+    // the index follows the page slots, the line being read follows the index
+    index = (LINENUM *)(mem.program_start + kPageSlots * kPageSize);
+    pages = 0;
+    mem.program_end = (unsigned char *)index;
+    if (mem.program_end + sizeof(LINENUM) >= mem.heap_begin)
+        goto sorry;
+
+    while (c >= 0)
+    {
+        line = mem.program_end + sizeof(LINENUM);
+        n = 0;
+        while ((c = fileio.get()) >= 0 && c != NL)
+        {
+            if (c == CR)
+                continue;
+            // room for the NL, and for the index entry of a new page
+            if (line + n + 2 >= mem.heap_begin)
+                goto sorry;
+            line[n++] = c;
+        }
+        line[n] = NL;
+
+        // the same steps as a line typed in
+        mem.toUppercaseBuffer();
+        if (!mem.bind_names(line))
+            goto sorry;
+        mem.txtpos = line;
+        mem.linenum = mem.testnum();
+        mem.ignore_blanks();
+        if (mem.linenum == 0)
+            continue;
+        if (mem.linenum == 0xFFFF || mem.linenum <= last)
+            goto how; // the lines must be in order
+        last = mem.linenum;
+
+        n = LINE_HEADER;
+        while (mem.txtpos[n - LINE_HEADER] != NL)
+            n++;
+        n++;
+#ifdef ALIGN_MEMORY
+        if (n & 1)
+            n++;
+#endif
+        if (n > kPageSize - kPageMark)
+            goto how;
+
+        if (fill + n > kPageSize - kPageMark)
+        {
+            if (!write_page(page, fill))
+                goto file;
+            fill = 0;
+        }
+        *(LINENUM *)(page + fill) = mem.linenum;
+        LINE_LENGTH(page + fill) = n;
+        memcpy(page + fill + kPageMark, mem.txtpos, n - kPageMark);
+        if (fill == 0)
+        {
+            index[pages++] = mem.linenum;
+            mem.program_end += sizeof(LINENUM);
+        }
+        fill += n;
+    }
+    if (fill && !write_page(page, fill))
+        goto file;
+    fileio.close();
+
+    for (n = 0; n < kPageSlots; n++)
+        slot_page[n] = -1;
+    clock = 0;
+    faults = 0;
+    active = true;
+    return true;
+
+how:
+    IO.printmsg(howmsg);
+    goto fail;
+sorry:
+    IO.printmsg(sorrymsg);
+    goto fail;
+file:
+    IO.printmsg(sdfilemsg);
+fail:
+    fileio.close();
+    stop();
+    return false;
+}
+
+boolean pagerClass::write_page(unsigned char *page, unsigned short fill)
+{
+    *(LINENUM *)(page + fill) = 0;
+    LINE_LENGTH(page + fill) = kPageMark;
+#ifdef ARDUINO
+    return fp.write(page, kPageSize) == kPageSize;
+#else
+    return fwrite(page, 1, kPageSize, fp) == kPageSize;
+#endif
+}
+
+void pagerClass::stop()
+{
+    if (!active && !fp)
+        return;
+#ifdef ARDUINO
+    fp.close();
+#else
+    fclose(fp);
+    fp = NULL;
+#endif
+    active = false;
+}
+
+boolean pagerClass::pinned(unsigned char slot)
+{
+    unsigned char *from = mem.program_start + slot * kPageSize;
+    unsigned char *p, *line;
+
+    // the stack holds nothing but FOR and GOSUB frames
+    for (p = mem.sp; p < mem.memory_end();)
+    {
+        if (*p == STACK_FOR_FLAG)
+        {
+            line = mem.pointer(((struct stack_for_frame *)p)->current_line);
+            p += sizeof(struct stack_for_frame);
+        }
+        else
+        {
+            line = mem.pointer(((struct stack_gosub_frame *)p)->current_line);
+            p += sizeof(struct stack_gosub_frame);
+        }
+        if (line >= from && line < from + kPageSize)
+            return true;
+    }
+    return false;
+}
+
+unsigned char *pagerClass::page_in(unsigned short page)
+{
+    unsigned char slot, victim = kPageSlots;
+    unsigned char *base;
+
+    for (slot = 0; slot < kPageSlots; slot++)
+        if (slot_page[slot] == (short)page)
+        {
+            slot_used[slot] = ++clock;
+            return mem.program_start + slot * kPageSize;
+        }
+
+    // the least recently used page that no frame points into
+    for (slot = 0; slot < kPageSlots; slot++)
+    {
+        if (slot_page[slot] >= 0 && pinned(slot))
+            continue;
+        if (victim == kPageSlots || slot_page[slot] < 0 ||
+            (unsigned short)(clock - slot_used[slot]) > (unsigned short)(clock - slot_used[victim]))
+            victim = slot;
+        if (slot_page[slot] < 0)
+            break;
+    }
+    if (victim == kPageSlots)
+        return NULL;
+
+    base = mem.program_start + victim * kPageSize;
+    slot_page[victim] = -1;
+#ifdef ARDUINO
+    if (!fp.seek((unsigned long)page * kPageSize) || fp.read(base, kPageSize) != kPageSize)
+        return NULL;
+#else
+    if (fseek(fp, (long)page * kPageSize, SEEK_SET) != 0 || fread(base, 1, kPageSize, fp) != kPageSize)
+        return NULL;
+    sim_event("page", page, victim);
+#endif
+    slot_page[victim] = page;
+    slot_used[victim] = ++clock;
+    faults++;
+    return base;
+}
+
+unsigned char *pagerClass::find(LINENUM linenum)
+{
+    unsigned short lo = 0, hi = pages, mid;
+    unsigned char *line;
+
+    if (pages == 0)
+        return mem.program_end;
+
+    // the last page starting at linenum or before
+    while (hi - lo > 1)
+    {
+        mid = (lo + hi) / 2;
+        if (index[mid] <= linenum)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    line = page_in(lo);
+    if (line == NULL)
+        return NULL;
+    while (*(LINENUM *)line != 0)
+    {
+        if (*(LINENUM *)line >= linenum)
+            return line;
+        line += LINE_LENGTH(line);
+    }
+    return next(line);
+}
+
+unsigned char *pagerClass::next(unsigned char *mark)
+{
+    unsigned short page = slot_page[(mark - mem.program_start) / kPageSize] + 1;
+
+    if (page == pages)
+        return mem.program_end;
+    return page_in(page);
+}
+
+unsigned char *pagerClass::follow(unsigned char *line)
+{
+    if (!active || line == mem.program_end || *(LINENUM *)line != 0)
+        return line;
+    line = next(line);
+    return line ? line : mem.program_end;
+}
+
+#endif /* ENABLE_PAGING */
@@ -0,0 +1,94 @@
+/// @file
+/// Paged program storage definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _PAGER_H_
+#define _PAGER_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+#ifdef ENABLE_PAGING
+
+// a page ends with an empty line header, line number 0
+#define kPageMark (LINE_HEADER)
+
+/// A program too large for the memory, run from a page file.
+/// PAGE cuts the program into pages of whole lines, kPageSize bytes each
+/// in the memory format, and writes them to kPageFilename.  The memory
+/// holds the first line number of every page, and kPageSlots pages at a
+/// time: findline() and the step to the next line read a page in when
+/// they need it, in place of the one used least recently.  A page with
+/// a FOR or GOSUB on the stack stays in, so the stack frames can point
+/// into it.
+class pagerClass
+{
+private:
+#ifdef ARDUINO
+    File fp;
+#else
+    FILE *fp;
+#endif
+    LINENUM *index; // first line of each page
+    short slot_page[kPageSlots];
+    unsigned short slot_used[kPageSlots];
+    unsigned short clock;
+
+    boolean write_page(unsigned char *page, unsigned short fill);
+    boolean pinned(unsigned char slot);
+    unsigned char *page_in(unsigned short page);
+
+public:
+    /** true while the program is paged */
+    boolean active;
+    unsigned short pages;
+    /** pages read in since PAGE */
+    unsigned short faults;
+
+    /** PAGE: false, with a message, if the program cannot be paged */
+    boolean load(const char *name);
+    /** back to a program in memory: the caller clears it */
+    void stop();
+
+    /** findline(): the first line numbered linenum or more */
+    unsigned char *find(LINENUM linenum);
+    /** the first line of the page after the one that ends at mark */
+    unsigned char *next(unsigned char *mark);
+    /** skip over the end of a page, for LIST */
+    unsigned char *follow(unsigned char *line);
+};
+
+extern pagerClass pager;
+
+#endif /* ENABLE_PAGING */
+
+#endif
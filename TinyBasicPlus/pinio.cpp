@@ -0,0 +1,147 @@
+/// @file
+/// Pin IO hardware abstraction layer implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "pinio.h"
+#include "events.h"
+#include "timer.h"
+
+#if kPinWatches > 4
+#error "add more pin_isr trampolines"
+#endif
+
+// one flag bit per watch slot, set from the interrupt handlers
+static volatile unsigned char pin_flags;
+
+static void pin_isr0() { pin_flags |= 0x01; }
+static void pin_isr1() { pin_flags |= 0x02; }
+static void pin_isr2() { pin_flags |= 0x04; }
+static void pin_isr3() { pin_flags |= 0x08; }
+
+static void (*const pin_isr[])(void) = {pin_isr0, pin_isr1, pin_isr2, pin_isr3};
+
+void pinioClass::reset()
+{
+    for (unsigned char p = 0; p < kPinCount; p++)
+        modes[p] = PIN_MODE_UNKNOWN;
+}
+
+void pinioClass::sample(unsigned char pin, short int *buf, unsigned short count, unsigned long interval)
+{
+    unsigned long next;
+
+    mode(pin, INPUT);
+    next = timers.now_us();
+    while (count--)
+    {
+        timers.wait_us(next);
+        *buf++ = analogRead(pin);
+        next += interval;
+    }
+}
+
+boolean pinioClass::watch(unsigned char pin, LINENUM line)
+{
+    unsigned char w, free = kPinWatches;
+
+    for (w = 0; w < kPinWatches; w++)
+    {
+        if (watches[w].line == 0)
+        {
+            if (free == kPinWatches)
+                free = w;
+            continue;
+        }
+        if (watches[w].pin != pin)
+            continue;
+
+        // a new handler for the same pin replaces the old one
+        if (watches[w].irq != PIN_NO_IRQ)
+            detachInterrupt(digitalPinToInterrupt(pin));
+        watches[w].line = 0;
+        watching--;
+        free = w;
+    }
+    if (line == 0)
+        return true;
+    if (free == kPinWatches)
+        return false;
+
+    w = free;
+    mode(pin, INPUT);
+    watches[w].pin = pin;
+    watches[w].line = line;
+    watches[w].level = digitalRead(pin);
+    watches[w].irq = PIN_NO_IRQ;
+    if (digitalPinToInterrupt(pin) != NOT_AN_INTERRUPT)
+    {
+        noInterrupts();
+        pin_flags &= ~(1 << w);
+        interrupts();
+        watches[w].irq = w;
+        attachInterrupt(digitalPinToInterrupt(pin), pin_isr[w], CHANGE);
+    }
+    watching++;
+    return true;
+}
+
+void pinioClass::unwatch()
+{
+    for (unsigned char w = 0; w < kPinWatches; w++)
+        if (watches[w].line != 0)
+            watch(watches[w].pin, 0);
+}
+
+void pinioClass::poll()
+{
+    unsigned char flags;
+
+#ifndef ARDUINO
+    sim_inject();
+#endif
+    noInterrupts();
+    flags = pin_flags;
+    pin_flags = 0;
+    interrupts();
+
+    for (unsigned char w = 0; w < kPinWatches; w++)
+    {
+        if (watches[w].line == 0)
+            continue;
+        if (watches[w].irq == PIN_NO_IRQ)
+        {
+            unsigned char level = digitalRead(watches[w].pin);
+            if (level == watches[w].level)
+                continue;
+            watches[w].level = level;
+        }
+        else if (!(flags & (1 << w)))
+            continue;
+        events.post(watches[w].line);
+    }
+}
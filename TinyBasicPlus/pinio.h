@@ -0,0 +1,131 @@
+/// @file
+/// Pin IO hardware abstraction layer definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _PINIO_H_
+#define _PINIO_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+#define PIN_MODE_UNKNOWN 0xFF
+#define PIN_NO_IRQ 0xFF
+
+/// ON PIN n CHANGE GOSUB line
+struct pin_watch
+{
+    LINENUM line; // 0 when the slot is free
+    unsigned char pin;
+    unsigned char irq;   // interrupt flag bit, or PIN_NO_IRQ if polled
+    unsigned char level; // last level seen by the poll
+};
+
+/// Pin IO for DWRITE, AWRITE, DREAD and AREAD.
+/// Each statement used to set the pin mode before touching the pin;
+/// here the current mode of every pin is cached, so the mode register
+/// is only written when a pin actually changes direction.
+///
+/// Watched pins use an interrupt when the pin has one: the interrupt
+/// only sets a flag, and the event is posted at the next statement
+/// boundary.  Other pins are polled there instead.
+class pinioClass
+{
+private:
+    unsigned char modes[kPinCount];
+    pin_watch watches[kPinWatches];
+
+    void poll();
+
+public:
+    /** number of pins with an ON PIN handler */
+    unsigned char watching;
+
+    /** ON PIN pin CHANGE GOSUB line, line 0 stops watching the pin */
+    boolean watch(unsigned char pin, LINENUM line);
+    /** program stopped: stop watching every pin */
+    void unwatch();
+    /** post an event for every watched pin that changed; cheap when none */
+    inline void check()
+    {
+        if (watching)
+            poll();
+    }
+
+    /** forget every cached mode */
+    void reset();
+    /** somebody else set the mode of the pin (SD library, tone, ...) */
+    inline void forget(unsigned char pin)
+    {
+        if (pin < kPinCount)
+            modes[pin] = PIN_MODE_UNKNOWN;
+    }
+    /** a pin number the statements can use */
+    inline boolean valid(VALUE pin)
+    {
+        return pin >= 0 && pin < kPinCount;
+    }
+    /** set the mode of a valid pin, unless it is in that mode already */
+    inline void mode(unsigned char pin, unsigned char m)
+    {
+        if (modes[pin] == m)
+            return;
+        modes[pin] = m;
+        pinMode(pin, m);
+    }
+
+    inline void dwrite(unsigned char pin, short int value)
+    {
+        mode(pin, OUTPUT);
+        digitalWrite(pin, value);
+    }
+    inline void awrite(unsigned char pin, short int value)
+    {
+        mode(pin, OUTPUT);
+        analogWrite(pin, value);
+    }
+    inline short int dread(unsigned char pin)
+    {
+        mode(pin, INPUT);
+        return digitalRead(pin);
+    }
+    inline short int aread(unsigned char pin)
+    {
+        mode(pin, INPUT);
+        return analogRead(pin);
+    }
+    /** fill buf with count AREADs of pin, one every interval microseconds */
+    void sample(unsigned char pin, short int *buf, unsigned short count, unsigned long interval);
+};
+
+extern pinioClass pins;
+
+#endif
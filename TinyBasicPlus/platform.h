@@ -39,6 +39,19 @@
 //#define ENABLE_FILEIO 1
 #undef ENABLE_FILEIO
 
+// LOAD and SAVE move the file through a buffer of this size: one SD
+// card sector
+#define kFileBuffer 512
+
+// PAGE "file" runs a program too large for the memory from the SD card.
+// Its lines go to a page file, and kPageSlots pages of kPageSize bytes
+// are kept in memory, read in as the program runs.  Needs ENABLE_FILEIO.
+//#define ENABLE_PAGING 1
+#undef ENABLE_PAGING
+#define kPageSize  256
+#define kPageSlots 6
+#define kPageFilename "pages.tmp"
+
 // this turns on "autorun".  if there's FileIO, and a file "autorun.bas",
 // then it will load it and run it when starting up
 //#define ENABLE_AUTORUN 1
@@ -66,6 +79,103 @@
 #define ENABLE_EEPROM 1
 //#undef ENABLE_EEPROM
 
+// ESAVE leaves out the text of REM lines, to fit a longer program in
+// the EEProm.  The REM itself stays, so GOTO and GOSUB still find the line.
+//#define ENABLE_EE_STRIPREM 1
+#undef ENABLE_EE_STRIPREM
+
+// SAVE MIN "file" and ESAVE MIN store the program without its comments
+// and the blanks it does not need, with an NL alone after each line.
+// A comment line that GOTO or GOSUB goes to stays, as a bare REM.
+// Needs ENABLE_LINK, which finds the jumps.
+#define ENABLE_MINIFY 1
+//#undef ENABLE_MINIFY
+
+// DIM arrays of integers, and the bulk statements and functions
+// that work on them: AFILL, ACOPY, AADD, ASCALE, ASUM, AMIN, AMAX
+#define ENABLE_ARRAYS 1
+//#undef ENABLE_ARRAYS
+
+// FIXED A, B makes A and B fixed point variables, with kFixedShift bits
+// of fraction, and numbers like 1.25 are fixed point.  Plain integer
+// math: no floating point library.  PRINT shows kFixedDigits decimals.
+// Half the bits of a value are the fraction: Q8.8 on the Arduino, Q16.16
+// on the desktop (see VALUE in globals.h).
+#define ENABLE_FIXED 1
+//#undef ENABLE_FIXED
+#define kFixedShift  (VALUE_BITS / 2)
+#define kFixedDigits (VALUE_BITS == 16 ? 3 : 4)
+
+// DATA lists integer constants for READ, and RESTORE n goes back to the
+// DATA from line n on.  RUN copies them into a table in the heap, so
+// READ does not parse the program text.
+#define ENABLE_DATA 1
+//#undef ENABLE_DATA
+
+// fused handlers for the statements loops are made of, when they start
+// a line: V=V+k, IF ... GOTO n, NEXT V and PRINT V
+#define ENABLE_FUSED 1
+//#undef ENABLE_FUSED
+
+// RUN checks the program first: GOTO and GOSUB to missing lines, NEXT
+// without FOR and FOR without NEXT are reported, and the lines of the
+// jumps with a constant line number are looked up once
+#define ENABLE_LINK 1
+//#undef ENABLE_LINK
+
+// timers for ON TIMER, SLEEP and the end of tones.  This is the number
+// of timers that can be armed at once; the wheel hashes them into
+// kWheelSize buckets of (1 << kWheelShift) milliseconds each.
+#define kTimerSlots 4
+#define kWheelSize  8
+#define kWheelShift 4
+
+// variables with longer names: each name gets one of kVarSlots slots
+// when its line is typed in.  Only the first kNameLength letters count.
+#ifdef ARDUINO
+  #define kVarSlots 8
+#else
+  #define kVarSlots 64
+#endif
+#define kNameLength 8
+
+// lines that can have a fused handler (a power of 2)
+#ifdef ARDUINO
+  #define kFusedLines 8
+#else
+  #define kFusedLines 256
+#endif
+
+// FOR and GOSUB frames the stack has room for.  The desktop build can
+// change it with -S.
+#ifdef ARDUINO
+  #define kStackFrames 5
+#else
+  #define kStackFrames 64
+#endif
+
+// ON ... GOSUB events waiting for the next statement boundary
+#define kEventQueue 4
+
+// pins whose mode is cached by the pin IO layer; DWRITE, DREAD, ON PIN...
+// refuse higher pin numbers
+#ifdef NUM_DIGITAL_PINS
+  #define kPinCount NUM_DIGITAL_PINS
+#else
+  #define kPinCount 24
+#endif
+
+// pins that can have an ON PIN handler at the same time (at most 4)
+#define kPinWatches 4
+
+// statements between two looks at the console for the break key
+// (Ctrl-C).  A keypress waits at most this long to be seen.
+#ifdef ARDUINO
+  #define kBreakEvery 16
+#else
+  #define kBreakEvery 1024
+#endif
+
 // Sometimes, we connect with a slower device as the console.
 // Set your console D0/D1 baud rate here (9600 baud default)
 #define kConsoleBaud 9600
@@ -95,21 +205,12 @@
   #undef ALIGN_MEMORY
 #endif
 
-#ifndef ARDUINO
-  // not an arduino, so we can disable these features.
-  // turn off EEProm
-  #undef ENABLE_EEPROM
-  #undef ENABLE_TONES
-#endif
-
-
 // includes, and settings for Arduino-specific features
 #ifdef ARDUINO
 
   // EEPROM
   #ifdef ENABLE_EEPROM
     #include <EEPROM.h>  /* NOTE: case sensitive */
-    static int eepos = 0;
   #endif
 
   // SD card File io
@@ -119,18 +220,13 @@
 
     // set this to the card select for your Arduino SD shield
     #define kSD_CS 10
-
-    #define kSD_Fail  0
-    #define kSD_OK    1
-
-    File fp;
   #endif
 
   // set up our RAM buffer size for program and user input
   // NOTE: This number will have to change if you include other libraries.
   //       It is also an estimation.  Might require adjustments...
   #ifdef ENABLE_FILEIO
-    #define kRamFileIO (1030) /* approximate */
+    #define kRamFileIO (1030 + kFileBuffer) /* approximate */
   #else
     #define kRamFileIO (0)
   #endif
@@ -141,7 +237,25 @@
     #define kRamTones (0)
   #endif
 
-  #define kRamSize  (RAMEND - 1160 - kRamFileIO - kRamTones) 
+  // the globals of the timers, the event queue, the pin modes, the
+  // streams and the long names, and the 43 bytes of the EEProm, link,
+  // DATA, array, fixed point and minify code (counted from the classes
+  // for the '328: 2 byte pointers, no padding)
+  #define kRamCore (204)
+
+  #ifdef ENABLE_FUSED
+    #define kRamFused (97) /* kFusedLines lines and the counters */
+  #else
+    #define kRamFused (0)
+  #endif
+
+  #ifdef ENABLE_PAGING
+    #define kRamPaging (64) /* approximate */
+  #else
+    #define kRamPaging (0)
+  #endif
+
+  #define kRamSize  (RAMEND - 1160 - kRamFileIO - kRamTones - kRamCore - kRamFused - kRamPaging) 
 
 #endif /* ARDUINO Specifics */
 
@@ -154,13 +268,80 @@
 #else
   #include <stdio.h>
   #include <stdlib.h>
-  #undef ENABLE_TONES
-
-  // size of our program ram
+  #include <stdint.h>
+
+  // desktop stand-ins for the Arduino core, implemented in cli/sim.cpp.
+  // pin traffic, tones and output go to the simulation event log.
+  #define INPUT  0
+  #define OUTPUT 1
+  #define LOW    0
+  #define HIGH   1
+  void pinMode(int pin, int mode);
+  void digitalWrite(int pin, int value);
+  int digitalRead(int pin);
+  void analogWrite(int pin, int value);
+  int analogRead(int pin);
+  void tone(int pin, unsigned int frequency, unsigned long duration = 0);
+  void noTone(int pin);
+
+  // every pin has an "interrupt", raised by the edges the mock injects
+  #define CHANGE 1
+  #define NOT_AN_INTERRUPT -1
+  #define digitalPinToInterrupt(p) (p)
+  #define noInterrupts()
+  #define interrupts()
+  void attachInterrupt(int irq, void (*isr)(void), int mode);
+  void detachInterrupt(int irq);
+
+  // a file backed EEProm, with the size of the '328 one
+  #define E2END 1023
+  class EEPROMClass
+  {
+  public:
+    unsigned char read(int idx);
+    void write(int idx, unsigned char val);
+  };
+  extern EEPROMClass EEPROM;
+
+  void sim_output(unsigned char c);
+  // the console: a byte from stdin, and whether Ctrl-C came since the
+  // last call (a SIGINT, or the byte itself on a pipe)
+  int sim_getchar(void);
+  unsigned char sim_break(void);
+  // the clock, RND, pin reads and console input go through here, to be
+  // recorded (-r) or replayed (-p): live is returned, or the value
+  // recorded with this tag (see cli/replay.cpp)
+  unsigned long sim_replay(char tag, unsigned long live);
+  // with the virtual clock (-s), a read of the clock or a pin moves it on
+  void sim_tick(void);
+  void sim_event(const char *what, int a, int b);
+  void sim_inject(void);
+  unsigned long sim_next_edge(unsigned long until);
+
+  // size of our program ram, unless -M gives another one.  It is
+  // reserved by sim_memory(), and only the pages used take real memory.
   #define kRamSize   64*1024 /* arbitrary - not dependant on libraries */
-
-  #ifdef ENABLE_FILEIO
-    FILE * fp;
+  unsigned char *sim_memory(unsigned long size);
+
+  // a 16 bit length in the line header, for lines longer than 255 bytes
+  // (make WIDE_LINES=1).  The EEProm and SAVE formats do not change.
+  //#define WIDE_LINES 1
+
+  // 16 bit values like the Arduino instead of 32 bit ones
+  // (make NARROW_VALUES=1), to try a program the way it runs there
+  //#define NARROW_VALUES 1
+
+  // LOAD, SAVE and FILES work on the current directory, and so does PAGE
+  #define ENABLE_FILEIO 1
+  #define ENABLE_PAGING 1
+
+  // lines started kJitThreshold times are compiled to machine code,
+  // up to kJitLines lines in kJitBytes of code.  -J turns it off.
+  #if defined(__x86_64__)
+    #define ENABLE_JIT 1
+    #define kJitLines     256 /* a power of 2 */
+    #define kJitThreshold 50
+    #define kJitBytes     65535
   #endif
 #endif
 
@@ -203,9 +384,7 @@
 
 #ifdef ENABLE_FILEIO
   // functions defined elsehwere
-  void cmd_Files( void );
   unsigned char * filenameWord(void);
-  static boolean sd_is_initialized = false;
 #endif
 
 
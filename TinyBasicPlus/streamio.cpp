@@ -28,22 +28,30 @@
 /// See the GNU General Public License for more details.
 
 #include "streamio.h"
+#include "estore.h"
+#include "fileio.h"
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
 
 void streamioClass::printnum(int num)
 {
+    // an int, for the sizes in MEM as well as the values, and unsigned,
+    // so the smallest value has a positive counterpart
+    unsigned int n = num;
     int digits = 0;
 
     if (num < 0)
     {
-        num = -num;
+        n = -n;
         outchar('-');
     }
     do
     {
-        pushb(num % 10 + '0');
-        num = num / 10;
+        pushb(n % 10 + '0');
+        n = n / 10;
         digits++;
-    } while (num > 0);
+    } while (n > 0);
 
     while (digits > 0)
     {
@@ -52,6 +60,43 @@ void streamioClass::printnum(int num)
     }
 }
 
+#ifdef ENABLE_FIXED
+void streamioClass::printfixed(VALUE num)
+{
+    DVALUE n = num;
+    DVALUE scale = 1;
+    DVALUE decimals;
+    int digits;
+
+    if (n < 0)
+    {
+        n = -n;
+        outchar('-');
+    }
+    for (digits = 0; digits < kFixedDigits; digits++)
+        scale *= 10;
+    // rounded to the last decimal shown, which can carry into the integer part
+    decimals = ((n & (((DVALUE)1 << kFixedShift) - 1)) * scale + ((DVALUE)1 << (kFixedShift - 1))) >> kFixedShift;
+    n >>= kFixedShift;
+    if (decimals >= scale)
+    {
+        decimals -= scale;
+        n++;
+    }
+    printnum(n);
+    if (decimals == 0)
+        return;
+
+    // no trailing zeros
+    outchar('.');
+    for (scale /= 10; decimals > 0; scale /= 10)
+    {
+        outchar(decimals / scale + '0');
+        decimals %= scale;
+    }
+}
+#endif
+
 void streamioClass::printUnum(unsigned int num)
 {
     int digits = 0;
@@ -137,7 +182,7 @@ void streamioClass::getln(char prompt)
             break;
         default:
             // We need to leave at least one space to allow us to shuffle the line into order
-            if (mem.txtpos == mem.variables_begin - 2)
+            if (mem.txtpos == mem.heap_begin - 2)
                 outchar(BELL);
             else
             {
@@ -149,18 +194,35 @@ void streamioClass::getln(char prompt)
     }
 }
 
-void streamioClass::printline()
+void streamioClass::printline(boolean tight)
 {
     LINENUM line_num;
+    unsigned char quote = 0;
 
     line_num = *((LINENUM *)(mem.list_line));
-    mem.list_line += sizeof(LINENUM) + sizeof(char);
+    mem.list_line += LINE_HEADER;
 
     // Output the line */
     printnum(line_num);
-    outchar(' ');
+    // a line number is read up to the first non digit
+    if (!tight || (*mem.list_line >= '0' && *mem.list_line <= '9'))
+        outchar(' ');
     while (*mem.list_line != NL)
     {
+        // spell out the variable names, outside the strings
+        if (quote)
+        {
+            if (*mem.list_line == quote)
+                quote = 0;
+        }
+        else if (*mem.list_line == '"' || *mem.list_line == '\'')
+            quote = *mem.list_line;
+        else if (*mem.list_line >= NAME_TOKEN)
+        {
+            printname(*mem.list_line);
+            mem.list_line++;
+            continue;
+        }
         outchar(*mem.list_line);
         mem.list_line++;
     }
@@ -170,7 +232,18 @@ void streamioClass::printline()
     if (ALIGN_UP(list_line) != list_line)
         mem.list_line++;
 #endif
-    line_terminator();
+    if (tight)
+        outchar(NL);
+    else
+        line_terminator();
+}
+
+void streamioClass::printname(unsigned char slot)
+{
+    unsigned char *name = mem.names + (slot - NAME_TOKEN) * kNameLength;
+
+    for (unsigned char i = 0; i < kNameLength && name[i] != 0; i++)
+        outchar(name[i]);
 }
 
 void streamioClass::line_terminator(void)
@@ -179,52 +252,160 @@ void streamioClass::line_terminator(void)
     outchar(NL);
 }
 
-int streamioClass::inchar()
+/***********************************************************/
+// Stream backends: each one reads a byte (-1 at the end of a load) and
+// writes one.  The console is called directly; the others, used while
+// loading or saving, go through the table below, indexed by streamType.
+
+struct consoleStream
 {
-    int v;
+    // wait for the next interrupt: the serial one wakes us for a byte,
+    // the millis() one every ms
+    static inline void idle()
+    {
+#ifdef __AVR__
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_mode();
+#endif
+    }
+    static inline int get()
+    {
 #ifdef ARDUINO
+        while (!Serial.available())
+            idle();
+        return Serial.read();
+#else
+        int v = sim_getchar();
 
-    switch (inStream)
-    {
-    case (streamType::kStreamFile):
-#ifdef ENABLE_FILEIO
-        v = fp.read();
-        if (v == NL)
-            v = CR; // file translate
-        if (!fp.available())
-        {
-            fp.close();
-            goto inchar_loadfinish;
-        }
+        // translation for desktop systems
+        if (v == LF)
+            v = CR;
         return v;
+#endif
+    }
+    static inline void put(unsigned char c)
+    {
+#ifdef ARDUINO
+        Serial.write(c);
 #else
+        putchar(c);
+        sim_output(c);
 #endif
-        break;
-    case (streamType::kStreamEEProm):
+    }
+};
+
+struct eepromStream
+{
+    static int get()
+    {
 #ifdef ENABLE_EEPROM
-#ifdef ARDUINO
-        v = EEPROM.read(eepos++);
-        if (v == '\0')
-        {
-            goto inchar_loadfinish;
-        }
+        return estore.get();
+#else
+        return -1;
+#endif
+    }
+    // ESAVE writes its tokens through estore itself
+    static void put(unsigned char /* c */)
+    {
+    }
+};
+
+struct fileStream
+{
+    static int get()
+    {
+#ifdef ENABLE_FILEIO
+        int v = fileio.get();
+        if (v < 0)
+            fileio.close();
+        else if (v == NL)
+            v = CR; // file translate
         return v;
+#else
+        return -1;
 #endif
+    }
+    static void put(unsigned char c)
+    {
+#ifdef ENABLE_FILEIO
+        fileio.put(c);
 #else
-        inStream = streamType::kStreamSerial;
-        return NL;
+        (void)c;
 #endif
-        break;
-    case (streamType::kStreamSerial):
-    default:
-        while (1)
-        {
-            if (Serial.available())
-                return Serial.read();
-        }
     }
+};
+
+// a buffer in RAM, read or written in place
+static const unsigned char *memory_in;
+static unsigned long memory_in_left;
+static unsigned char *memory_out;
+static unsigned short memory_out_left;
+static unsigned short memory_out_used;
+
+struct memoryStream
+{
+    static int get()
+    {
+        if (memory_in_left == 0)
+            return -1;
+        memory_in_left--;
+        return *memory_in++;
+    }
+    static void put(unsigned char c)
+    {
+        if (memory_out_left == 0)
+            return;
+        memory_out_left--;
+        memory_out[memory_out_used++] = c;
+    }
+};
+
+struct streamBackend
+{
+    int (*get)(void);
+    void (*put)(unsigned char c);
+};
+
+// in the order of streamType
+static const streamBackend backends[] = {
+    {consoleStream::get, consoleStream::put},
+    {eepromStream::get, eepromStream::put},
+    {fileStream::get, fileStream::put},
+    {memoryStream::get, memoryStream::put},
+};
+
+void streamioClass::memory_read(const unsigned char *buffer, unsigned long length)
+{
+    memory_in = buffer;
+    memory_in_left = length;
+    inStream = streamType::kStreamMemory;
+}
+
+void streamioClass::memory_write(unsigned char *buffer, unsigned short length)
+{
+    memory_out = buffer;
+    memory_out_left = length;
+    memory_out_used = 0;
+    outStream = streamType::kStreamMemory;
+}
+
+unsigned short streamioClass::memory_written()
+{
+    return memory_out_used;
+}
+
+int streamioClass::inchar()
+{
+    int v;
+
+    if (inStream == streamType::kStreamSerial)
+        return consoleStream::get();
 
-inchar_loadfinish:
+    v = backends[(int)inStream].get();
+    if (v >= 0)
+        return v;
+
+    // the end of a load
     inStream = streamType::kStreamSerial;
     inhibitOutput = false;
 
@@ -234,17 +415,6 @@ inchar_loadfinish:
         triggerRun = true;
     }
     return NL; // trigger a prompt.
-
-#else
-    // otherwise. desktop!
-    int got = getchar();
-
-    // translation for desktop systems
-    if (got == LF)
-        got = CR;
-
-    return got;
-#endif
 }
 
 void streamioClass::outchar(unsigned char c)
@@ -252,29 +422,10 @@ void streamioClass::outchar(unsigned char c)
     if (inhibitOutput)
         return;
 
-#ifdef ARDUINO
-#ifdef ENABLE_FILEIO
-    if (outStream == kStreamFile)
-    {
-        // output to a file
-        fp.write(c);
-    }
+    if (outStream == streamType::kStreamSerial)
+        consoleStream::put(c);
     else
-#endif
-#ifdef ARDUINO
-#ifdef ENABLE_EEPROM
-        if (outStream == streamType::kStreamEEProm)
-    {
-        EEPROM.write(eepos++, c);
-    }
-    else
-#endif /* ENABLE_EEPROM */
-#endif /* ARDUINO */
-        Serial.write(c);
-
-#else
-    putchar(c);
-#endif
+        backends[(int)outStream].put(c);
 }
 
 void streamioClass::pushb(unsigned char b)
@@ -291,19 +442,17 @@ unsigned char streamioClass::popb()
     return b;
 }
 
-unsigned char streamioClass::breakcheck(void)
+unsigned char streamioClass::breakcheck(boolean now)
 {
+    if (--break_countdown && !now)
+        return 0;
+    break_countdown = kBreakEvery;
 #ifdef ARDUINO
     if (Serial.available())
         return Serial.read() == CTRLC;
     return 0;
 #else
-#ifdef __CONIO__
-    if (kbhit())
-        return getch() == CTRLC;
-    else
-#endif
-        return 0;
+    return sim_break();
 #endif
 }
 
@@ -30,7 +30,9 @@
 #ifndef _STREAMIO_H_
 #define _STREAMIO_H_
 
+#ifdef ARDUINO
 #include "Arduino.h"
+#endif
 #include "globals.h"
 #include "strings.h"
 #include "usermem.h"
@@ -40,6 +42,8 @@ class streamioClass
 private:
     void pushb(unsigned char b);
     unsigned char popb();
+    /** statements left until breakcheck() looks at the console */
+    unsigned short break_countdown = 1;
 
 public:
     /** these will select, at runtime, where IO happens through for load/save */
@@ -47,7 +51,8 @@ public:
     {
         kStreamSerial = 0,
         kStreamEEProm,
-        kStreamFile
+        kStreamFile,
+        kStreamMemory
     };
 
     streamType inStream = streamType::kStreamSerial;
@@ -55,17 +60,35 @@ public:
 
     void printnum(int num);
     void printUnum(unsigned int num);
+#ifdef ENABLE_FIXED
+    /** a fixed point value, with up to kFixedDigits decimals */
+    void printfixed(VALUE num);
+#endif
     unsigned char print_quoted_string(void);
     void printmsgNoNL(const unsigned char *msg);
     void printmsg(const unsigned char *msg);
     void getln(char prompt);
-    void printline();
+    /** the line at list_line as LIST shows it, or tight: with no blank
+     *  after the line number and an NL alone at the end */
+    void printline(boolean tight = false);
+    /** the name of a variable slot */
+    void printname(unsigned char slot);
     void line_terminator(void);
     int inchar();
     void outchar(unsigned char c);
     /** trap non printable chars */
     void outchar_printable(unsigned char c);
-    unsigned char breakcheck(void);
+    /** true when the break key was hit; polls every kBreakEvery calls,
+        or at once when the caller is idle anyway */
+    unsigned char breakcheck(boolean now = false);
+
+    /** read the input from a buffer in RAM, without copying it */
+    void memory_read(const unsigned char *buffer, unsigned long length);
+    /** send the output to a buffer in RAM, up to length bytes */
+    void memory_write(unsigned char *buffer, unsigned short length);
+    unsigned short memory_written();
 };
 
+extern streamioClass IO;
+
 #endif
\ No newline at end of file
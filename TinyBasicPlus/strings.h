@@ -41,11 +41,28 @@ static const unsigned char howmsg[]           PROGMEM =	"Invalid expression.";
 static const unsigned char sorrymsg[]         PROGMEM = "Out of memory!";
 static const unsigned char initmsg[]          PROGMEM = " ** Casasoft Arduino BASIC " kVersion " **";
 static const unsigned char memorymsg[]        PROGMEM = " bytes free.";
-#ifdef ARDUINO
+static const unsigned char samplemsg[]        PROGMEM = " bytes of samples.";
+static const unsigned char ofmsg[]            PROGMEM = " of ";
+static const unsigned char namesmsg[]         PROGMEM = " variable names used.";
+#ifdef ENABLE_PAGING
+static const unsigned char pagesmsg[]         PROGMEM = " program pages, ";
+static const unsigned char faultsmsg[]        PROGMEM = " read in.";
+#endif
 #ifdef ENABLE_EEPROM
 static const unsigned char eeprommsg[]        PROGMEM = " EEProm bytes total.";
 static const unsigned char eepromamsg[]       PROGMEM = " EEProm bytes available.";
+static const unsigned char eeemptymsg[]       PROGMEM = "No program in EEProm.";
+#endif
+#ifdef ENABLE_LINK
+static const unsigned char nolinemsg[]        PROGMEM = ": no line ";
+static const unsigned char noformsg[]         PROGMEM = ": NEXT without FOR.";
+static const unsigned char nonextmsg[]        PROGMEM = ": FOR without NEXT.";
 #endif
+#ifdef ENABLE_DATA
+static const unsigned char baddatamsg[]       PROGMEM = ": bad DATA.";
+static const unsigned char nodatamsg[]        PROGMEM = "Out of DATA.";
+static const unsigned char datamsg[]          PROGMEM = " DATA items, ";
+static const unsigned char databytesmsg[]     PROGMEM = " bytes.";
 #endif
 static const unsigned char breakmsg[]         PROGMEM = "break!";
 static const unsigned char unimplimentedmsg[] PROGMEM = "Unimplemented.";
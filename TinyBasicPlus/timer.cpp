@@ -0,0 +1,300 @@
+/// @file
+/// Timer wheel scheduler implementation.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#include "timer.h"
+#include "events.h"
+
+#ifndef ARDUINO
+#include <time.h>
+#endif
+#if defined(ARDUINO) && defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+
+// longest nap on the desktop, so that a break is not held up for too long
+#define kIdleSlice 20
+
+unsigned long timerClass::now()
+{
+#ifdef ARDUINO
+    return millis();
+#else
+    return now_us() / 1000UL;
+#endif
+}
+
+unsigned long timerClass::now_us()
+{
+#ifdef ARDUINO
+    return micros();
+#else
+    static unsigned long start = 0;
+    struct timespec ts;
+    unsigned long t;
+
+    if (simulated)
+        return simulated_us;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    t = ts.tv_sec * 1000000UL + ts.tv_nsec / 1000UL;
+    if (start == 0)
+        start = t - 1;
+    return sim_replay('T', t - start);
+#endif
+}
+
+void timerClass::wait_us(unsigned long until)
+{
+#ifndef ARDUINO
+    if (simulated)
+    {
+        if ((long)(until - simulated_us) > 0)
+            simulated_us = until;
+        return;
+    }
+#endif
+    while ((long)(now_us() - until) < 0)
+        ;
+}
+
+void timerClass::reset()
+{
+    unsigned char t;
+
+#ifdef ENABLE_TONES
+    for (t = 0; t < kTimerSlots; t++)
+        if (entries[t].kind == TIMER_TONE)
+            noTone(kPiezoPin);
+#endif
+    for (t = 0; t < kTimerSlots; t++)
+        entries[t].kind = TIMER_FREE;
+    for (t = 0; t < kWheelSize; t++)
+        wheel[t] = TIMER_NONE;
+    armed = 0;
+    cursor = now() >> kWheelShift;
+    sleep_stmt = NULL;
+}
+
+void timerClass::stop()
+{
+    for (unsigned char t = 0; t < kTimerSlots; t++)
+        if (entries[t].kind == TIMER_GOSUB)
+        {
+            unlink(t);
+            entries[t].kind = TIMER_FREE;
+        }
+    sleep_stmt = NULL;
+}
+
+void timerClass::link(unsigned char t)
+{
+    unsigned char b = (entries[t].due >> kWheelShift) & (kWheelSize - 1);
+
+    entries[t].next = wheel[b];
+    wheel[b] = t;
+    if (armed == 0 || (long)(entries[t].due - next_due) < 0)
+        next_due = entries[t].due;
+    armed++;
+}
+
+void timerClass::unlink(unsigned char t)
+{
+    unsigned char *p = &wheel[(entries[t].due >> kWheelShift) & (kWheelSize - 1)];
+
+    while (*p != t)
+        p = &entries[*p].next;
+    *p = entries[t].next;
+    armed--;
+}
+
+boolean timerClass::arm(unsigned char kind, unsigned short ms, unsigned short period, LINENUM line)
+{
+    unsigned char t;
+
+    for (t = 0; t < kTimerSlots; t++)
+        if (entries[t].kind == TIMER_FREE)
+            break;
+    if (t == kTimerSlots)
+        return false;
+
+    entries[t].kind = kind;
+    entries[t].line = line;
+    entries[t].period = period;
+    entries[t].due = now() + ms;
+    link(t);
+    return true;
+}
+
+boolean timerClass::every(unsigned short ms, LINENUM line)
+{
+    unsigned char t;
+
+    // a new ON TIMER for the same handler replaces the old one
+    for (t = 0; t < kTimerSlots; t++)
+        if (entries[t].kind == TIMER_GOSUB && entries[t].line == line)
+        {
+            unlink(t);
+            entries[t].kind = TIMER_FREE;
+        }
+    if (ms == 0)
+        return true;
+    return arm(TIMER_GOSUB, ms, ms, line);
+}
+
+boolean timerClass::tone_end(unsigned short ms)
+{
+    unsigned char t;
+
+    for (t = 0; t < kTimerSlots; t++)
+        if (entries[t].kind == TIMER_TONE)
+        {
+            unlink(t);
+            entries[t].kind = TIMER_FREE;
+        }
+    return arm(TIMER_TONE, ms, 0, 0);
+}
+
+void timerClass::fire(unsigned char t)
+{
+    switch (entries[t].kind)
+    {
+    case TIMER_GOSUB:
+        events.post(entries[t].line);
+        break;
+#ifdef ENABLE_TONES
+    case TIMER_TONE:
+        noTone(kPiezoPin);
+        break;
+#endif
+    }
+}
+
+void timerClass::poll(unsigned long t)
+{
+    unsigned long tick = t >> kWheelShift;
+    unsigned char steps;
+
+    // walk the buckets the clock has moved across, at most one full turn
+    for (steps = 0; steps < kWheelSize; steps++)
+    {
+        unsigned char b = cursor & (kWheelSize - 1);
+        unsigned char e = wheel[b];
+
+        while (e != TIMER_NONE)
+        {
+            unsigned char next = entries[e].next;
+
+            // timers further down the road stay in the bucket
+            if ((long)(t - entries[e].due) >= 0)
+            {
+                unlink(e);
+                fire(e);
+                if (entries[e].period)
+                {
+                    entries[e].due += entries[e].period;
+                    // skip the periods we were too busy to see
+                    if ((long)(t - entries[e].due) >= 0)
+                        entries[e].due = t + entries[e].period;
+                    link(e);
+                }
+                else
+                    entries[e].kind = TIMER_FREE;
+            }
+            e = next;
+        }
+        if (cursor == tick)
+            break;
+        cursor++;
+    }
+    cursor = tick;
+
+    // find out when we have to look again
+    next_due = t + 0x7FFFFFFFUL;
+    for (steps = 0; steps < kTimerSlots; steps++)
+        if (entries[steps].kind != TIMER_FREE && (long)(entries[steps].due - next_due) < 0)
+            next_due = entries[steps].due;
+}
+
+boolean timerClass::sleep(unsigned char *stmt, unsigned long ms)
+{
+    // coming back to a SLEEP after an event handler: keep the old wake time
+    if (stmt == sleep_stmt)
+        return false;
+    sleep_stmt = stmt;
+    wake = now() + ms;
+    return true;
+}
+
+boolean timerClass::awake()
+{
+    if ((long)(now() - wake) < 0)
+        return false;
+    sleep_stmt = NULL;
+    return true;
+}
+
+void timerClass::idle()
+{
+    unsigned long until = wake;
+
+    if (armed && (long)(next_due - until) < 0)
+        until = next_due;
+#ifdef ARDUINO
+#ifdef __AVR__
+    // doze until the next interrupt: the millis() tick or a serial byte
+    if ((long)(now() - until) < 0)
+    {
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_mode();
+    }
+#else
+    yield();
+#endif
+#else
+    long left;
+
+    // an edge injected by the pin mock is something that happens, too
+    until = sim_next_edge(until);
+    left = (long)(until - now());
+    if (simulated)
+    {
+        // skip straight to the next thing that happens
+        if (left > 0)
+            simulated_us = until * 1000UL;
+    }
+    else if (left > 0)
+    {
+        struct timespec ts;
+        if (left > kIdleSlice)
+            left = kIdleSlice;
+        ts.tv_sec = 0;
+        ts.tv_nsec = left * 1000000L;
+        nanosleep(&ts, NULL);
+    }
+#endif
+}
@@ -0,0 +1,126 @@
+/// @file
+/// Timer wheel scheduler definition.
+///
+/// @author
+/// copyright (c) 2021 Roberto Ceccarelli - Casasoft
+/// http://strawberryfield.altervista.org
+///
+/// original work by
+///    Gordon Brandly (Tiny Basic for 68000)
+///    Mike Field <hamster@snap.net.nz> (Arduino Basic) (port to Arduino)
+///    Scott Lawrence <yorgle@gmail.com> (TinyBasic Plus) (features, etc)
+///
+/// @copyright
+/// This is free software:
+/// you can redistribute it and/or modify it
+/// under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with these files.
+/// If not, see <http://www.gnu.org/licenses/>.
+///
+/// @remark
+/// This software is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+/// See the GNU General Public License for more details.
+
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#endif
+#include "platform.h"
+#include "globals.h"
+#include "usermem.h"
+
+// what happens when a timer expires
+#define TIMER_FREE  0 // slot not in use
+#define TIMER_GOSUB 1 // post an ON TIMER event
+#define TIMER_TONE  2 // end of a TONE
+
+#define TIMER_NONE 0xFF // end of a wheel bucket chain
+
+struct timer_entry
+{
+    unsigned long due;
+    unsigned short period; // 0 for one-shot timers
+    LINENUM line;
+    unsigned char kind;
+    unsigned char next; // next timer in the same bucket
+};
+
+/// Hashed timer wheel.
+/// Armed timers are chained in the bucket of their expiry tick, so a
+/// poll only looks at the buckets the clock moved across since the last
+/// one.  The interpreter calls check() at every statement boundary: with
+/// nothing armed it costs a single comparison.  With a timer armed it
+/// also reads the clock, millis() on the board and clock_gettime() on
+/// the desktop, and walks the wheel only once the earliest timer is due.
+class timerClass
+{
+private:
+    timer_entry entries[kTimerSlots];
+    unsigned char wheel[kWheelSize];
+    unsigned long cursor;   // last wheel tick polled
+    unsigned long next_due; // earliest expiry among armed timers
+    unsigned char *sleep_stmt;
+    unsigned long wake;
+
+    void link(unsigned char t);
+    void unlink(unsigned char t);
+    void fire(unsigned char t);
+    void poll(unsigned long t);
+    boolean arm(unsigned char kind, unsigned short ms, unsigned short period, LINENUM line);
+
+public:
+    /** number of armed timers */
+    unsigned char armed;
+#ifndef ARDUINO
+    /** virtual clock: time moves on when the program waits, and a
+     *  little at each read of the clock or a pin (see cli/sim.cpp) */
+    boolean simulated;
+    unsigned long simulated_us;
+#endif
+
+    /** milliseconds since startup */
+    unsigned long now();
+    /** microseconds since startup */
+    unsigned long now_us();
+    /** busy wait until the microsecond clock reaches until */
+    void wait_us(unsigned long until);
+    /** disarm every timer */
+    void reset();
+    /** program stopped: disarm the ON TIMERs, let tones play out */
+    void stop();
+    /** ON TIMER ms GOSUB line, ms=0 disarms the timer for line */
+    boolean every(unsigned short ms, LINENUM line);
+    /** schedule the end of a tone */
+    boolean tone_end(unsigned short ms);
+
+    /** run expired timers; a clock read when one is armed */
+    inline void check()
+    {
+        if (armed)
+        {
+            unsigned long t = now();
+            if ((long)(t - next_due) >= 0)
+                poll(t);
+        }
+    }
+
+    /** start a SLEEP for the statement at stmt, unless it is being resumed.
+     *  returns true when the sleep has just been started */
+    boolean sleep(unsigned char *stmt, unsigned long ms);
+    /** true when the current SLEEP is over */
+    boolean awake();
+    /** idle until the SLEEP is over or the next timer is due */
+    void idle();
+};
+
+extern timerClass timers;
+
+#endif
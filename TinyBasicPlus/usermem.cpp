@@ -28,6 +28,18 @@
 /// See the GNU General Public License for more details.
 
 #include "usermem.h"
+#include "timer.h"
+#include "pinio.h"
+#include "pager.h"
+#include "arrays.h"
+#include "jit.h"
+#include "fused.h"
+#include "link.h"
+#include "data.h"
+
+#ifndef ARDUINO
+#include <string.h>
+#endif
 
 void usermemClass::ignore_blanks(void)
 {
@@ -94,9 +106,28 @@ unsigned short usermemClass::testnum(void)
     return num;
 }
 
+unsigned char *usermemClass::constant(unsigned char *p, VALUE *v)
+{
+    *v = 0;
+    if (*p == '0')
+        return p + 1;
+    if (*p < '1' || *p > '9')
+        return NULL;
+    do
+    {
+        *v = *v * 10 + *p - '0';
+        p++;
+    } while (*p >= '0' && *p <= '9');
+    return p;
+}
+
 unsigned char *usermemClass::findline(void)
 {
     unsigned char *line = program_start;
+#ifdef ENABLE_PAGING
+    if (pager.active)
+        return pager.find(linenum);
+#endif
     while (1)
     {
         if (line == program_end)
@@ -106,8 +137,71 @@ unsigned char *usermemClass::findline(void)
             return line;
 
         // Add the line length onto the current address, to get to the next line;
-        line += line[sizeof(LINENUM)];
+        line += LINE_LENGTH(line);
+    }
+}
+
+void usermemClass::walk(keyword_visitor visit, void *context)
+{
+    unsigned char *txtpos_was = txtpos;
+    LINENUM linenum_was = linenum;
+    unsigned char *line, *p, *q;
+
+    for (line = program_start; line != program_end; line += LINE_LENGTH(line))
+    {
+        boolean start = true; // at the start of a statement
+
+        p = line + LINE_HEADER;
+        while (*p != NL)
+        {
+            if (*p == ':')
+            {
+                start = true;
+                p++;
+                continue;
+            }
+            if (*p == SPACE || *p == TAB)
+            {
+                p++;
+                continue;
+            }
+            if (*p == '"' || *p == '\'')
+            {
+                // a quote starting a statement is a comment, else a string
+                if (*p == '\'' && start)
+                    break;
+                for (q = p + 1; *q != *p && *q != NL; q++)
+                    ;
+                p = *q == NL ? q : q + 1;
+                start = false;
+                continue;
+            }
+            start = false;
+            if (*p < 'A' || *p > 'Z')
+            {
+                p++;
+                continue;
+            }
+
+            txtpos = p;
+            scantable(keywords);
+            if (table_index == KW_DEFAULT)
+            {
+                // a variable or a function
+                while (*p >= 'A' && *p <= 'Z')
+                    p++;
+                continue;
+            }
+            if (table_index == KW_REM)
+                break;
+            p = visit(line, txtpos, context);
+            if (p == NULL)
+                goto done;
+        }
     }
+done:
+    txtpos = txtpos_was;
+    linenum = linenum_was;
 }
 
 void usermemClass::toUppercaseBuffer(void)
@@ -128,9 +222,166 @@ void usermemClass::toUppercaseBuffer(void)
     }
 }
 
+// the length of the longest word of table at text, 0 if none
+static unsigned char word_at(const unsigned char *table, unsigned char *text, unsigned char *word)
+{
+    unsigned char i, index, length = 0;
+
+    for (index = 0; pgm_read_byte(table) != 0; index++)
+    {
+        for (i = 0; (pgm_read_byte(table + i) & 0x7F) == text[i]; i++)
+            if (pgm_read_byte(table + i) & 0x80)
+            {
+                if (i + 1 > length)
+                {
+                    length = i + 1;
+                    *word = index;
+                }
+                break;
+            }
+        while (!(pgm_read_byte(table++) & 0x80))
+            ;
+    }
+    return length;
+}
+
+// the length of a reserved word inside a statement: a function, TO,
+// STEP, HIGH, MIN... or a keyword after IF, 0 if none.  Inside a statement a
+// word only counts when no letter follows, so TOTAL is a name.
+static unsigned char reserved(unsigned char *text, unsigned char *word)
+{
+    const unsigned char *table;
+    unsigned char n, length = 0, l, w = 0;
+
+    *word = KW_DEFAULT;
+    for (n = 0; n < 8; n++)
+    {
+        switch (n)
+        {
+        case 0: table = keywords; break;
+        case 1: table = func_tab; break;
+        case 2: table = to_tab; break;
+        case 3: table = step_tab; break;
+        case 4: table = on_tab; break;
+        case 5: table = change_tab; break;
+        case 6: table = highlow_tab; break;
+        default: table = min_tab; break;
+        }
+        l = word_at(table, text, &w);
+        if (l > length && (text[l] < 'A' || text[l] > 'Z'))
+        {
+            length = l;
+            *word = n == 0 ? w : (unsigned char)KW_DEFAULT;
+        }
+    }
+    return length;
+}
+
+static boolean isNameChar(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+boolean usermemClass::bind_names(unsigned char *text, boolean add)
+{
+    unsigned char *to = text;
+    unsigned char quote = 0;
+    boolean start = true; // at the start of a statement
+    unsigned char n, r, i, slot, word;
+
+    while (*text != NL)
+    {
+        // strings and comments stay as they are
+        if (quote)
+        {
+            if (*text == quote)
+                quote = 0;
+            *to++ = *text++;
+            continue;
+        }
+        if (*text == '"' || *text == '\'')
+        {
+            quote = *text;
+            start = false;
+            *to++ = *text++;
+            continue;
+        }
+        if (*text >= NAME_TOKEN)
+        {
+            // only a slot may have the top bit set
+            *to++ = '?';
+            text++;
+            continue;
+        }
+        if (*text < 'A' || *text > 'Z')
+        {
+            // the line number and blanks leave us at the start
+            if (*text == ':')
+                start = true;
+            else if (*text != ' ' && (*text < '0' || *text > '9' || to != text))
+                start = false;
+            *to++ = *text++;
+            continue;
+        }
+
+        for (r = 1; isNameChar(text[r]); r++)
+            ;
+
+        // a statement keyword is read wherever it starts, as in FORI=1TO9,
+        // unless it starts a name being assigned to, as in ONE=1
+        n = 0;
+        if (start)
+        {
+            n = word_at(keywords, text, &word);
+            if (n && text[r] == '=' && r > n && !(r == n + 1 && (word == KW_FOR || word == KW_LET)))
+                n = 0;
+        }
+        if (n == 0)
+            n = reserved(text, &word);
+        start = false;
+        if (n)
+        {
+            while (n--)
+                *to++ = *text++;
+            if (word == KW_REM || word == KW_LOAD || word == KW_SAVE || word == KW_CHAIN || word == KW_PAGE)
+                while (*text != NL) // a comment, or a file name
+                    *to++ = *text++;
+            continue;
+        }
+
+        if (r == 1)
+        {
+            *to++ = *text++;
+            continue;
+        }
+
+        // look the name up, or give it the next slot
+        for (slot = 0; slot < name_count; slot++)
+        {
+            for (i = 0; i < kNameLength && i < r && names[slot * kNameLength + i] == text[i]; i++)
+                ;
+            if (i == kNameLength || (i == r && names[slot * kNameLength + i] == 0))
+                break;
+        }
+        if (slot == name_count)
+        {
+            if (!add || slot == kVarSlots)
+                return false;
+            for (i = 0; i < kNameLength; i++)
+                names[slot * kNameLength + i] = i < r ? text[i] : 0;
+            name_count++;
+            set_var(NAME_TOKEN + slot, 0);
+        }
+        *to++ = NAME_TOKEN + slot;
+        text += r;
+    }
+    *to = NL;
+    return true;
+}
+
 /************************************************************/
 
-short int usermemClass::expr4(void)
+VALUE usermemClass::expr4(void)
 {
     // fix provided by Jurg Wullschleger wullschleger@gmail.com
     // fixes whitespace and unary operations
@@ -143,31 +394,71 @@ short int usermemClass::expr4(void)
     }
     // end fix
 
+#ifdef ENABLE_FIXED
+    fixed = 0;
+    if (*txtpos == '.')
+        return decimal(0);
+#endif
+
     if (*txtpos == '0')
     {
         txtpos++;
+#ifdef ENABLE_FIXED
+        if (*txtpos == '.')
+            return decimal(0);
+#endif
         return 0;
     }
 
     if (*txtpos >= '1' && *txtpos <= '9')
     {
-        short int a = 0;
+        VALUE a = 0;
         do
         {
             a = a * 10 + *txtpos - '0';
             txtpos++;
         } while (*txtpos >= '0' && *txtpos <= '9');
+#ifdef ENABLE_FIXED
+        if (*txtpos == '.')
+            return decimal(a);
+#endif
         return a;
     }
 
+    // a variable with a longer name
+    if (txtpos[0] >= NAME_TOKEN)
+    {
+#ifdef ENABLE_ARRAYS
+        if (txtpos[1] == '(')
+        {
+            VALUE *e = element(*txtpos++);
+            return e == NULL ? 0 : *e;
+        }
+#endif
+#ifdef ENABLE_FIXED
+        fixed = is_fixed(*txtpos);
+#endif
+        return *var(*txtpos++);
+    }
+
     // Is it a function or variable reference?
     if (txtpos[0] >= 'A' && txtpos[0] <= 'Z')
     {
-        short int a;
+        VALUE a;
         // Is it a variable reference (single alpha)
         if (txtpos[1] < 'A' || txtpos[1] > 'Z')
         {
-            a = ((short int *)variables_begin)[*txtpos - 'A'];
+#ifdef ENABLE_ARRAYS
+            if (txtpos[1] == '(')
+            {
+                VALUE *e = element(*txtpos++);
+                return e == NULL ? 0 : *e;
+            }
+#endif
+#ifdef ENABLE_FIXED
+            fixed = is_fixed(*txtpos);
+#endif
+            a = *var(*txtpos);
             txtpos++;
             return a;
         }
@@ -189,13 +480,46 @@ short int usermemClass::expr4(void)
         }
 
         txtpos++;
-        a = expression();
+#ifdef ENABLE_ARRAYS
+        // ASUM, AMIN and AMAX take the name of an array
+        if (f == FUNC_ASUM || f == FUNC_AMIN || f == FUNC_AMAX)
+        {
+            array_header *arr = NULL;
+
+            ignore_blanks();
+            if (!isNotVariable())
+                arr = arrays.find(*txtpos++);
+            ignore_blanks();
+            if (arr == NULL || *txtpos != ')')
+            {
+                expression_error = 1;
+                return 0;
+            }
+            txtpos++;
+            if (f == FUNC_ASUM)
+                return arrays.sum(arr);
+            if (f == FUNC_AMIN)
+                return arrays.lowest(arr);
+            return arrays.highest(arr);
+        }
+#endif
+        a = typed_expression();
         if (*txtpos != ')')
         {
             expression_error = 1;
             return 0;
         }
         txtpos++;
+#ifdef ENABLE_FIXED
+        // ABS keeps a fixed point value as it is, SGN only needs its
+        // sign: the other functions take an integer
+        if (f != FUNC_ABS)
+        {
+            if (fixed && f != FUNC_SGN)
+                a = integer(a);
+            fixed = 0;
+        }
+#endif
         switch (f)
         {
         case FUNC_PEEK:
@@ -213,29 +537,54 @@ short int usermemClass::expr4(void)
                 return 1;
             return a;
 
-#ifdef ARDUINO
         case FUNC_AREAD:
-            pinMode(a, INPUT);
-            return analogRead(a);
         case FUNC_DREAD:
-            pinMode(a, INPUT);
-            return digitalRead(a);
+            if (!pins.valid(a))
+            {
+                expression_error = 1;
+                return 0;
+            }
+            if (f == FUNC_AREAD)
+                return pins.aread(a);
+            return pins.dread(a);
+
+        case FUNC_MILLIS:
+            if (a <= 0)
+                a = 1;
+#ifndef ARDUINO
+            sim_tick();
 #endif
+            return (VALUE)(timers.now() / a);
+
+        case FUNC_SAMPLE:
+            if (a < 0 || a >= (VALUE)sample_count)
+            {
+                expression_error = 1;
+                return 0;
+            }
+            return samples[a];
+        case FUNC_SCOUNT:
+            return sample_count;
 
         case FUNC_RND:
 #ifdef ARDUINO
             return (random(a));
 #else
-            return (rand() % a);
+            return (sim_replay('R', rand()) % a);
 #endif
+
+        default:
+            // a function left out of this build
+            expression_error = 1;
+            return 0;
         }
     }
 
     if (*txtpos == '(')
     {
-        short int a;
+        VALUE a;
         txtpos++;
-        a = expression();
+        a = typed_expression();
         if (*txtpos != ')')
         {
             expression_error = 1;
@@ -245,13 +594,22 @@ short int usermemClass::expr4(void)
         txtpos++;
         return a;
     }
+
+    expression_error = 1;
+    return 0;
 }
 
-short int usermemClass::expr3(void)
+VALUE usermemClass::expr3(void)
 {
-    short int a, b;
+    VALUE a, b;
+#ifdef ENABLE_FIXED
+    unsigned char a_fixed;
+#endif
 
     a = expr4();
+#ifdef ENABLE_FIXED
+    a_fixed = fixed;
+#endif
 
     ignore_blanks(); // fix for eg:  100 a = a + 1
 
@@ -261,30 +619,64 @@ short int usermemClass::expr3(void)
         {
             txtpos++;
             b = expr4();
+#ifdef ENABLE_FIXED
+            // an integer times a fixed point value needs no scaling
+            if (a_fixed && fixed)
+                a = fit(((DVALUE)a * b) >> kFixedShift);
+            else if (a_fixed || fixed)
+                a = fit((DVALUE)a * b);
+            else
+#endif
             a *= b;
+#ifdef ENABLE_FIXED
+            a_fixed |= fixed;
+#endif
         }
         else if (*txtpos == '/')
         {
             txtpos++;
             b = expr4();
-            if (b != 0)
-                a /= b;
-            else
+            if (b == 0)
                 expression_error = 1;
+#ifdef ENABLE_FIXED
+            else if (fixed)
+            {
+                // scaled up first: the quotient keeps its fraction
+                a = fit((DVALUE)a * ((DVALUE)1 << (a_fixed ? kFixedShift : 2 * kFixedShift)) / b);
+                a_fixed = 1;
+            }
+#endif
+            else if (b == -1)
+                a = -a; // the smallest value divided by -1 traps on some processors
+            else
+                a /= b;
         }
         else
+        {
+#ifdef ENABLE_FIXED
+            fixed = a_fixed;
+#endif
             return a;
+        }
     }
 }
 
-short int usermemClass::expr2(void)
+VALUE usermemClass::expr2(void)
 {
-    short int a, b;
+    VALUE a, b;
+#ifdef ENABLE_FIXED
+    unsigned char a_fixed = 0;
+#endif
 
     if (*txtpos == '-' || *txtpos == '+')
         a = 0;
     else
+    {
         a = expr3();
+#ifdef ENABLE_FIXED
+        a_fixed = fixed;
+#endif
+    }
 
     while (1)
     {
@@ -292,22 +684,47 @@ short int usermemClass::expr2(void)
         {
             txtpos++;
             b = expr3();
+#ifdef ENABLE_FIXED
+            if (a_fixed || fixed)
+            {
+                a = fit((DVALUE)convert(a, a_fixed, 1) - convert(b, fixed, 1));
+                a_fixed = 1;
+                continue;
+            }
+#endif
             a -= b;
         }
         else if (*txtpos == '+')
         {
             txtpos++;
             b = expr3();
+#ifdef ENABLE_FIXED
+            if (a_fixed || fixed)
+            {
+                a = fit((DVALUE)convert(a, a_fixed, 1) + convert(b, fixed, 1));
+                a_fixed = 1;
+                continue;
+            }
+#endif
             a += b;
         }
         else
+        {
+#ifdef ENABLE_FIXED
+            fixed = a_fixed;
+#endif
             return a;
+        }
     }
 }
 
-short int usermemClass::expression(void)
+VALUE usermemClass::typed_expression(void)
 {
-    short int a, b;
+    VALUE a, b;
+    unsigned char relop;
+#ifdef ENABLE_FIXED
+    unsigned char a_fixed;
+#endif
     expression_error = 0;
 
     a = expr2();
@@ -316,39 +733,48 @@ short int usermemClass::expression(void)
         return a;
 
     scantable(relop_tab);
-    if (table_index == RELOP_UNKNOWN)
+    relop = table_index;
+    if (relop == RELOP_UNKNOWN)
         return a;
 
-    switch (table_index)
+#ifdef ENABLE_FIXED
+    a_fixed = fixed;
+#endif
+    b = expr2();
+#ifdef ENABLE_FIXED
+    // compared as fixed point if either side is, and the answer is not
+    if (a_fixed || fixed)
+    {
+        a = convert(a, a_fixed, 1);
+        b = convert(b, fixed, 1);
+    }
+    fixed = 0;
+#endif
+
+    switch (relop)
     {
     case RELOP_GE:
-        b = expr2();
         if (a >= b)
             return 1;
         break;
     case RELOP_NE:
     case RELOP_NE_BANG:
-        b = expr2();
         if (a != b)
             return 1;
         break;
     case RELOP_GT:
-        b = expr2();
         if (a > b)
             return 1;
         break;
     case RELOP_EQ:
-        b = expr2();
         if (a == b)
             return 1;
         break;
     case RELOP_LE:
-        b = expr2();
         if (a <= b)
             return 1;
         break;
     case RELOP_LT:
-        b = expr2();
         if (a < b)
             return 1;
         break;
@@ -358,14 +784,79 @@ short int usermemClass::expression(void)
 
 /**********************************************/
 
+void usermemClass::begin()
+{
+#ifndef ARDUINO
+    if (program == NULL)
+        program = sim_memory(memory_size);
+#endif
+#ifdef ENABLE_FIXED
+    memset(fixed_vars, 0, sizeof(fixed_vars));
+#endif
+    program_start = program;
+    program_reset();
+    sp = memory_end(); // Needed for printnum
+#ifdef ALIGN_MEMORY
+    // Ensure these memory blocks start on even pages
+    stack_limit = ALIGN_DOWN(memory_end() - STACK_SIZE);
+    variables_begin = ALIGN_DOWN(stack_limit - VAR_COUNT * VAR_SIZE);
+    names = ALIGN_DOWN(variables_begin - kVarSlots * kNameLength);
+#else
+    stack_limit = memory_end() - STACK_SIZE;
+    variables_begin = stack_limit - VAR_COUNT * VAR_SIZE;
+    names = variables_begin - kVarSlots * kNameLength;
+#endif
+    heap_reset();
+}
+
 void usermemClass::program_reset()
 {
+#ifdef ENABLE_PAGING
+    pager.stop();
+#endif
     program_end = program_start;
+    name_count = 0;
+    heap_reset();
+#ifdef ENABLE_JIT
+    jit.reset();
+#endif
+#ifdef ENABLE_FUSED
+    fused.reset();
+#endif
 }
 
-unsigned short usermemClass::free_mem()
+PROGOFF usermemClass::free_mem()
 {
-    return variables_begin - program_end;
+    return heap_begin - program_end;
+}
+
+unsigned char *usermemClass::heap_alloc(PROGOFF size)
+{
+    // leave room to type in a line
+    if (size + 2 * sizeof(LINENUM) + 2 > free_mem())
+        return NULL;
+    heap_begin = ALIGN_DOWN(heap_begin - size);
+    return heap_begin;
+}
+
+void usermemClass::heap_reset()
+{
+    heap_begin = names;
+    samples = NULL;
+    sample_count = 0;
+    sample_room = 0;
+#ifdef ENABLE_ARRAYS
+    arrays.reset();
+#endif
+#ifdef ENABLE_LINK
+    linker.reset();
+#endif
+#ifdef ENABLE_DATA
+    data.reset();
+#endif
+#ifdef ENABLE_FIXED
+    clear_fixed();
+#endif
 }
 
 void usermemClass::find_newline()
@@ -374,12 +865,95 @@ void usermemClass::find_newline()
         txtpos++;
 }
 
-void usermemClass::set_var(char var, short value)
+#ifdef ENABLE_ARRAYS
+VALUE *usermemClass::element(unsigned char v)
+{
+    array_header *a = arrays.find(v);
+    VALUE i;
+
+    if (a == NULL || *txtpos != '(')
+    {
+        expression_error = 1;
+        return NULL;
+    }
+    txtpos++;
+    i = expression();
+    if (expression_error || *txtpos != ')' || i < 0 || (UVALUE)i >= a->count)
+    {
+        expression_error = 1;
+        return NULL;
+    }
+    txtpos++;
+    return arrays.data(a) + i;
+}
+#endif
+
+#ifdef ENABLE_FIXED
+VALUE usermemClass::fit(DVALUE v)
+{
+    if ((VALUE)v != v)
+    {
+        expression_error = 1;
+        return 0;
+    }
+    return v;
+}
+
+VALUE usermemClass::decimal(VALUE a)
+{
+    DVALUE digits = 0, scale = 1;
+
+    // digits past what the fraction can hold are read, and left out
+    for (txtpos++; *txtpos >= '0' && *txtpos <= '9'; txtpos++)
+        if (scale < 100000L)
+        {
+            digits = digits * 10 + *txtpos - '0';
+            scale *= 10;
+        }
+    fixed = 1;
+    return fit((DVALUE)a * (1 << kFixedShift) + (digits * (1 << kFixedShift) + scale / 2) / scale);
+}
+
+VALUE usermemClass::convert(VALUE value, unsigned char from_fixed, boolean to_fixed)
+{
+    if (from_fixed && !to_fixed)
+        return integer(value);
+    if (to_fixed && !from_fixed)
+        return fit((DVALUE)value * (1 << kFixedShift));
+    return value;
+}
+
+boolean usermemClass::make_fixed(unsigned char v)
+{
+    unsigned char i = var_index(v);
+
+    if (is_fixed(v))
+        return true;
+    expression_error = 0;
+    *var(v) = convert(*var(v), 0, 1);
+    if (expression_error)
+        return false;
+    fixed_vars[i >> 3] |= 1 << (i & 7);
+    return true;
+}
+
+void usermemClass::clear_fixed()
+{
+    unsigned char i;
+
+    for (i = 0; i < VAR_COUNT; i++)
+        if (fixed_vars[i >> 3] & (1 << (i & 7)))
+            ((VALUE *)variables_begin)[i] = integer(((VALUE *)variables_begin)[i]);
+    memset(fixed_vars, 0, sizeof(fixed_vars));
+}
+#endif
+
+void usermemClass::set_var(unsigned char v, VALUE value)
 {
-    ((short int *)variables_begin)[var - 'A'] = value;
+    *var(v) = value;
 }
 
-bool usermemClass::isNotAlpha()
+bool usermemClass::isNotVariable()
 {
-    return (*txtpos < 'A' || *txtpos > 'Z');
+    return (*txtpos < 'A' || *txtpos > 'Z') && *txtpos < NAME_TOKEN;
 }
\ No newline at end of file
@@ -30,22 +30,57 @@
 #ifndef _USERMEM_H_
 #define _USERMEM_H_
 
+#ifdef ARDUINO
 #include "Arduino.h"
+#endif
 #include "platform.h"
 #include "keywords.h"
 #include "globals.h"
 
 typedef short unsigned LINENUM;
 
+// a line in the program memory: its number, its length with this header,
+// then the text up to NL.  WIDE_LINES takes lines longer than 255 bytes.
+#ifdef WIDE_LINES
+typedef unsigned short LINELEN;
+#else
+typedef unsigned char LINELEN;
+#endif
+#define LINE_HEADER (sizeof(LINENUM) + sizeof(LINELEN))
+#define LINE_LENGTH(line) (*(LINELEN *)((line) + sizeof(LINENUM)))
+
+// called by usermemClass::walk() at a keyword of the program, with
+// table_index set: its line, and the text after it.  Returns where the
+// walk goes on in the line, or NULL to stop it.
+typedef unsigned char *(*keyword_visitor)(unsigned char *line, unsigned char *p, void *context);
+
 class usermemClass
 {
 private:
-    short int expr4(void);
-    short int expr3(void);
-    short int expr2(void);
+    VALUE expr4(void);
+    VALUE expr3(void);
+    VALUE expr2(void);
+#ifdef ENABLE_FIXED
+    /** one bit for each variable, set when it is fixed point */
+    unsigned char fixed_vars[(VAR_COUNT + 7) / 8];
+    /** v as a VALUE, or expression_error when it does not fit */
+    VALUE fit(DVALUE v);
+    /** the number at txtpos, a '.' after its integer part a */
+    VALUE decimal(VALUE a);
+    /** value, fixed point if from_fixed, as fixed point or as an integer */
+    VALUE convert(VALUE value, unsigned char from_fixed, boolean to_fixed);
+#endif
 
 public:
+#ifdef ARDUINO
     unsigned char program[kRamSize];
+    inline unsigned char *memory_end() { return program + sizeof(program); }
+#else
+    /** reserved by begin(), memory_size bytes: -M sets the size */
+    unsigned char *program;
+    unsigned long memory_size = kRamSize;
+    inline unsigned char *memory_end() { return program + memory_size; }
+#endif
     unsigned char *txtpos, *list_line, *tmptxtpos;
     unsigned char expression_error;
     unsigned char *tempsp;
@@ -55,30 +90,121 @@ public:
     unsigned char *program_end;
     unsigned char *stack; // Software stack for things that should go on the CPU stack
     unsigned char *variables_begin;
+    unsigned char *names; // kVarSlots names of kNameLength, below the variables
+    unsigned char name_count;
+    unsigned char *heap_begin; // blocks allocated below the variables
     unsigned char *current_line;
     unsigned char *sp;
 
     unsigned char table_index;
     LINENUM linenum;
 
+    /** depth of the stack, in FOR frames: set before the interpreter starts */
+    unsigned short stack_frames = kStackFrames;
+
+    /** pointers in the program memory to and from stack frame offsets */
+    inline PROGOFF offset(unsigned char *p) { return p == NULL ? PROGOFF_NULL : p - program; }
+    inline unsigned char *pointer(PROGOFF o) { return o == PROGOFF_NULL ? NULL : program + o; }
+
     void ignore_blanks(void);
     void scantable(const unsigned char *table);
     unsigned short testnum(void);
+    /** the number at p as expr4 reads it, wrapping around the same way:
+     *  the text after it, NULL if p is not a number */
+    unsigned char *constant(unsigned char *p, VALUE *v);
     unsigned char *findline(void);
+    /** call visit at each keyword of the program, past the strings and
+     *  the comments.  txtpos and linenum are left as they were. */
+    void walk(keyword_visitor visit, void *context);
     void toUppercaseBuffer(void);
+    /** turn the longer variable names in the line at text into slots,
+     *  false if there are no slots left.  Without add, only names that
+     *  already have a slot are taken, false at any other one (INPUT) */
+    boolean bind_names(unsigned char *text, boolean add = true);
+
+    /** the value of an expression, fixed point or not as it comes out
+     *  (see fixed) */
+    VALUE typed_expression(void);
+#ifdef ENABLE_FIXED
+    /** the last value of an expression is fixed point */
+    unsigned char fixed;
+    /** the integer part of a fixed point value */
+    inline VALUE integer(VALUE v) { return v / (1 << kFixedShift); }
+    inline boolean is_fixed(unsigned char v)
+    {
+        return fixed_vars[var_index(v) >> 3] & (1 << (var_index(v) & 7));
+    }
+    /** FIXED var: var is fixed point from now on, false if its value
+     *  does not fit */
+    boolean make_fixed(unsigned char var);
+    /** the value of the last expression as fixed point or as an integer,
+     *  expression_error if it does not fit */
+    inline VALUE convert(VALUE value, boolean to_fixed)
+    {
+        return convert(value, fixed, to_fixed);
+    }
+    /** every variable back to an integer */
+    void clear_fixed();
+#endif
+    /** the value of an expression, as fixed point or as an integer */
+    inline VALUE expression_as(boolean to_fixed)
+    {
+        VALUE v = typed_expression();
+#ifdef ENABLE_FIXED
+        if (!expression_error)
+            v = convert(v, to_fixed);
+#else
+        (void)to_fixed;
+#endif
+        return v;
+    }
+    /** the value of an expression as an integer */
+    inline VALUE expression(void)
+    {
+        VALUE v = typed_expression();
+#ifdef ENABLE_FIXED
+        if (fixed)
+            v = integer(v);
+#endif
+        return v;
+    }
 
-    short int expression(void);
+    /** burst of AREAD samples, allocated from the heap */
+    short int *samples;
+    unsigned short sample_count;
+    unsigned short sample_room;
 
+    /** lay out the stack, variables and names, with an empty program */
+    void begin();
     /** execute new command */ 
     void program_reset();
+    /** allocate size bytes between the program and the variables, NULL if there is no room */
+    unsigned char *heap_alloc(PROGOFF size);
+    /** release everything allocated from the heap */
+    void heap_reset();
     /** return free memory amount */
-    unsigned short free_mem();
+    PROGOFF free_mem();
     /** Find the end of the freshly entered line */
     void find_newline();
+    /** the index of the variable for a letter or a name slot */
+    inline unsigned char var_index(unsigned char c)
+    {
+        return c >= NAME_TOKEN ? 26 + c - NAME_TOKEN : c - 'A';
+    }
+    /** the variable for a letter or a name slot */
+    inline VALUE *var(unsigned char c)
+    {
+        return (VALUE *)variables_begin + var_index(c);
+    }
+#ifdef ENABLE_ARRAYS
+    /** the element of the array of var indexed by the "(i)" at txtpos,
+     *  NULL with expression_error set if it is not there */
+    VALUE *element(unsigned char var);
+#endif
     /** Store value in var */
-    void set_var(char var, short value);
-    /** Check if current char is not an alpha character */
-    bool isNotAlpha();
+    void set_var(unsigned char var, VALUE value);
+    /** Check if current char is not a variable */
+    bool isNotVariable();
 };
 
 extern usermemClass mem;
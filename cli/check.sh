@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# check.sh [-u]
+#
+# runs examples/*.bas and tests/*.bas with ./tbp on the virtual clock and
+# compares their output with tests/expected/<name>.<bits>, for the width
+# tbp was built with (make, or make NARROW_VALUES=1).  A tests/<name>.in
+# file is typed in as the input.  The free memory MEM prints depends on
+# the build (WIDE_LINES, the stack) and is left out of the comparison.
+# With -u the expected output is written instead.  make check runs it for
+# both widths.
+
+cd "$(dirname "$0")" || exit 2
+update=0
+[ "$1" = "-u" ] && update=1
+
+bits=32
+[ "$(printf 'PRINT 32767+1\nBYE\n' | ./tbp | tr -d '\r' | grep -c '^-32768$')" = 1 ] && bits=16
+
+failed=0
+for f in ../examples/*.bas ../tests/*.bas; do
+    name=$(basename "$f" .bas)
+    input=../tests/$name.in
+    [ -f "$input" ] || input=/dev/null
+    expected=../tests/expected/$name.$bits
+    out=$( (cat "$input"; echo BYE) | ./tbp -s "$f" 2>&1 | tr -d '\r' |
+        sed 's/^[0-9]* bytes free\.$/N bytes free./')
+    if [ $update = 1 ]; then
+        printf '%s\n' "$out" > "$expected"
+    elif printf '%s\n' "$out" | diff -u "$expected" -; then
+        echo "ok   $name ($bits bits)"
+    else
+        echo "FAIL $name ($bits bits)"
+        failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,62 @@
+#!/bin/sh
+#
+# difftest.sh [program.bas...]
+#
+# runs each program with tbp and as the C++ that tbp --emit-cpp makes of
+# it, compares the two outputs and prints how long each run took and how
+# many times faster the C++ was (examples/*.bas and tests/*.bas by
+# default).  Programs that can not be translated are skipped, and times
+# in ms printed by the programs are left out of the comparison.  Run make
+# first.
+
+cd "$(dirname "$0")" || exit 2
+CXX=${CXX:-g++}
+TMP=$(mktemp -d) || exit 2
+trap 'rm -rf "$TMP"' EXIT
+
+[ $# -eq 0 ] && set -- ../examples/*.bas ../tests/*.bas
+
+# the output of the program alone: no banner, no prompt, no Ok.
+filter()
+{
+    tr -d '\r' | sed -e '1{/^Starting up/d;}' -e '/^Ok\.$/d' -e '/^>/d' \
+        -e 's/[0-9][0-9]* ms/N ms/g' | sed -e '/./,$!d'
+}
+
+# the time in ms
+now()
+{
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+failed=0
+for f in "$@"; do
+    name=$(basename "$f" .bas)
+    if ! ./tbp --emit-cpp "$f" > "$TMP/$name.cpp" 2> "$TMP/$name.err"; then
+        echo "skip $f: $(head -n 1 "$TMP/$name.err")"
+        continue
+    fi
+    if ! $CXX -O2 -o "$TMP/$name" "$TMP/$name.cpp"; then
+        echo "FAIL $f: the translation does not compile"
+        failed=1
+        continue
+    fi
+    start=$(now)
+    echo BYE | ./tbp "$f" > "$TMP/$name.int" 2>&1
+    middle=$(now)
+    "$TMP/$name" < /dev/null > "$TMP/$name.out" 2>&1
+    end=$(now)
+    int=$((middle - start))
+    cpp=$((end - middle))
+    times="tbp $int ms, C++ $cpp ms, $(awk "BEGIN { printf \"%.1f\", $int / ($cpp ? $cpp : 1) }")x"
+
+    filter < "$TMP/$name.int" > "$TMP/$name.int.f"
+    filter < "$TMP/$name.out" > "$TMP/$name.out.f"
+    if diff -u "$TMP/$name.int.f" "$TMP/$name.out.f"; then
+        echo "ok   $f ($times)"
+    else
+        echo "FAIL $f ($times)"
+        failed=1
+    fi
+done
+exit $failed
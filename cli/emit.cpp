@@ -0,0 +1,1280 @@
+/* --emit-cpp: translate a BASIC program into a standalone C++ program
+ *
+ *  the program is read into memory the way the interpreter keeps it,
+ *  through the same upper casing and name binding, and every statement
+ *  is parsed with the interpreter's own keyword tables, scantable() and
+ *  testnum().  Expressions follow the grammar of expression(), but turn
+ *  into C++ instead of a value: arithmetic as wide as a VALUE, left to
+ *  right, with the constant parts folded.
+ *
+ *  each line becomes a label.  FOR and GOSUB push a frame holding the
+ *  address of the line to go back to, so NEXT and RETURN are a computed
+ *  goto, and a GOTO to an expression looks the line up in a table.  The
+ *  translation prints what the interpreter prints, errors included,
+ *  minus the Ok. prompt.  Statements that need the hardware, the files
+ *  or the interpreter itself (LIST, RUN, DWRITE, ON, PEEK...) are refused.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "platform.h"
+#include "globals.h"
+#include "strings.h"
+#include "keywords.h"
+#include "usermem.h"
+#include "streamio.h"
+#include "arrays.h"
+#include "link.h"
+#include "emit.h"
+
+static FILE * out;
+static unsigned char * line;    /* the line being translated */
+static int refused;             /* some statement could not be translated */
+static int bad;                 /* the expression does not parse */
+static int temps;               /* temporaries of the current statement */
+static int computed_goto;       /* a GOTO or GOSUB to an expression */
+
+/* what the program prints when it stops on an error: the failures */
+#define FAIL_HOW   0
+#define FAIL_SORRY 1
+static char ** failures;
+static int failure_count;
+static int expr_fail;           /* of the expression being translated, -1 for none */
+
+struct operand
+{
+    int constant;               /* value is known now */
+    VALUE value;
+    char text[ 48 ];            /* a literal, variable or temporary */
+};
+
+static const char prelude[] = R"(#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#pragma GCC diagnostic ignored "-Wunused-label"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+#define FAIL_HOW   0
+#define FAIL_SORRY 1
+extern const char * const failures[];
+
+struct array
+{
+    VALUE * data;
+    unsigned short count;
+};
+
+struct frame
+{
+    VALUE * var; /* NULL for a GOSUB */
+    VALUE terminal, step;
+    void * resume;
+};
+
+struct line
+{
+    unsigned short number;
+    void * at;
+};
+
+static struct frame frames[ STACK_BYTES / GOSUB_FRAME + 1 ];
+static int depth;
+static unsigned stack_used;     /* in bytes, as the interpreter counts them */
+static VALUE heap[ HEAP_BYTES / sizeof( VALUE ) + 1 ];
+static unsigned heap_used;
+static struct timespec start;
+
+static void fail( int f )
+{
+    fputs( failures[ f ], stdout );
+    exit( 1 );
+}
+
+static void newline( void )
+{
+    fputs( "\r\n", stdout );
+}
+
+static void printnum( int num )
+{
+    printf( "%d", num );
+}
+
+static VALUE millis( VALUE d )
+{
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    unsigned long ms = ( now.tv_sec - start.tv_sec ) * 1000UL + now.tv_nsec / 1000000 - start.tv_nsec / 1000000;
+    return (VALUE)( ms / d );
+}
+
+static void pause( VALUE ms )
+{
+    struct timespec t = { ms / 1000, ( ms % 1000 ) * 1000000L };
+    fflush( stdout );
+    nanosleep( &t, NULL );
+}
+
+static VALUE input( void )
+{
+    char buffer[ 128 ];
+    char * c;
+    int sign;
+    VALUE v;
+
+    while( 1 ) {
+        fputs( "?", stdout );
+        fflush( stdout );
+        if( !fgets( buffer, sizeof( buffer ), stdin )) exit( 0 );
+        buffer[ strcspn( buffer, "\r\n" ) ] = '\0';
+        fputs( buffer, stdout );
+        newline();
+        for( c = buffer, sign = 1 ; *c == ' ' || *c == '\t' || *c == '-' || *c == '+' ; c++ )
+            if( *c == '-' ) sign = -sign;
+        if( *c < '0' || *c > '9' ) continue;
+        for( v = 0 ; *c >= '0' && *c <= '9' ; c++ )
+            v = (VALUE)( (DVALUE)v * 10 + *c - '0' );
+        return (VALUE)( (DVALUE)sign * v );
+    }
+}
+
+static void forpush( VALUE * var, VALUE initial, VALUE terminal, VALUE step, void * resume )
+{
+    if( stack_used + FOR_FRAME > STACK_BYTES ) fail( FAIL_SORRY );
+    *var = initial;
+    frames[ depth ].var = var;
+    frames[ depth ].terminal = terminal;
+    frames[ depth ].step = step;
+    frames[ depth++ ].resume = resume;
+    stack_used += FOR_FRAME;
+}
+
+static void gosub( void * resume )
+{
+    if( stack_used + GOSUB_FRAME > STACK_BYTES ) fail( FAIL_SORRY );
+    frames[ depth ].var = NULL;
+    frames[ depth++ ].resume = resume;
+    stack_used += GOSUB_FRAME;
+}
+
+/* drop frame i and the ones above it */
+static void unwind( int i )
+{
+    while( depth > i )
+        stack_used -= frames[ --depth ].var ? FOR_FRAME : GOSUB_FRAME;
+}
+
+/* where NEXT var loops back to, NULL when the loop is over */
+static void * next( VALUE * var )
+{
+    for( int i = depth - 1 ; i >= 0 ; i-- ) {
+        struct frame * f = &frames[ i ];
+        if( f->var != var ) continue;
+        *var = (VALUE)( (DVALUE)*var + f->step );
+        if(( f->step > 0 && *var <= f->terminal ) || ( f->step < 0 && *var >= f->terminal ))
+            return f->resume;
+        unwind( i );
+        return NULL;
+    }
+    fail( FAIL_HOW );
+    return NULL;
+}
+
+static void * ret( void )
+{
+    for( int i = depth - 1 ; i >= 0 ; i-- ) {
+        if( frames[ i ].var ) continue;
+        void * resume = frames[ i ].resume;
+        unwind( i );
+        return resume;
+    }
+    fail( FAIL_HOW );
+    return NULL;
+}
+
+static void dim( struct array * a, VALUE n )
+{
+    unsigned long bytes = (unsigned long)( n + 1 ) * sizeof( VALUE ) + ARRAY_HEADER;
+
+    if( n < 0 || (UVALUE)n > 65534 || a->data ) fail( FAIL_HOW );
+    if( bytes + HEAP_SLACK > HEAP_BYTES - heap_used ) fail( FAIL_SORRY );
+    a->data = heap + heap_used / sizeof( VALUE );
+    a->count = n + 1;
+    heap_used += bytes;
+    memset( a->data, 0, a->count * sizeof( VALUE ));
+}
+
+static struct array * need( struct array * a )
+{
+    if( !a->data ) fail( FAIL_HOW );
+    return a;
+}
+
+static void afill( struct array * a, VALUE value )
+{
+    for( unsigned short i = 0 ; i < a->count ; i++ ) a->data[ i ] = value;
+}
+
+static void acopy( struct array * d, struct array * s )
+{
+    memmove( d->data, s->data, ( d->count < s->count ? d->count : s->count ) * sizeof( VALUE ));
+}
+
+static void aadd( struct array * d, struct array * s )
+{
+    unsigned short n = d->count < s->count ? d->count : s->count;
+    for( unsigned short i = 0 ; i < n ; i++ ) d->data[ i ] = (VALUE)( (DVALUE)d->data[ i ] + s->data[ i ] );
+}
+
+static void ascale( struct array * a, VALUE mul, VALUE div )
+{
+    if( div == 0 ) fail( FAIL_HOW );
+    for( unsigned short i = 0 ; i < a->count ; i++ ) a->data[ i ] = (DVALUE)a->data[ i ] * mul / div;
+}
+
+static VALUE asum( struct array * a )
+{
+    UVALUE s = 0;
+    for( unsigned short i = 0 ; i < a->count ; i++ ) s += a->data[ i ];
+    return (VALUE)s;
+}
+
+static VALUE amin( struct array * a )
+{
+    VALUE m = a->data[ 0 ];
+    for( unsigned short i = 1 ; i < a->count ; i++ ) m = a->data[ i ] < m ? a->data[ i ] : m;
+    return m;
+}
+
+static VALUE amax( struct array * a )
+{
+    VALUE m = a->data[ 0 ];
+    for( unsigned short i = 1 ; i < a->count ; i++ ) m = a->data[ i ] > m ? a->data[ i ] : m;
+    return m;
+}
+)";
+
+
+/* loading *******************************************************************/
+
+static int load( const char * filename )
+{
+    FILE * f;
+    LINENUM last = 0;
+    unsigned char * text;
+    unsigned char * p;
+    int c = 0, length, n = 0;
+
+    f = fopen( filename, "r" );
+    if( !f ) {
+        perror( filename );
+        return 0;
+    }
+    mem.begin();
+    while( c != EOF ) {
+        /* read the line where the interpreter reads it, after the program */
+        text = p = mem.program_end + sizeof( LINENUM );
+        while(( c = fgetc( f )) != EOF && c != '\n' ) {
+            if( c == '\r' ) continue;
+            if( p >= mem.heap_begin - 2 ) {
+                fprintf( stderr, "%s: the program does not fit in memory\n", filename );
+                fclose( f );
+                return 0;
+            }
+            *p++ = c;
+        }
+        *p = NL;
+        n++;
+        mem.toUppercaseBuffer();
+        if( !mem.bind_names( text )) {
+            fprintf( stderr, "%s:%d: more than %d variable names\n", filename, n, kVarSlots );
+            fclose( f );
+            return 0;
+        }
+        mem.txtpos = text;
+        mem.linenum = mem.testnum();
+        mem.ignore_blanks();
+        if( *mem.txtpos == NL ) continue; /* empty, or a line number alone */
+        if( mem.linenum == 0 || mem.linenum == 0xFFFF || mem.linenum <= last ) {
+            fprintf( stderr, "%s:%d: %s\n", filename, n,
+                     mem.linenum == 0 ? "a line without a number" : "line numbers must go up" );
+            fclose( f );
+            return 0;
+        }
+        for( length = 0 ; mem.txtpos[ length ] != NL ; length++ )
+            ;
+        length += 1 + LINE_HEADER;
+        if( length > (LINELEN)~0 ) {
+            fprintf( stderr, "%s:%d: line too long\n", filename, n );
+            fclose( f );
+            return 0;
+        }
+        memmove( mem.program_end + LINE_HEADER, mem.txtpos,
+                 length - LINE_HEADER );
+        *(LINENUM *)mem.program_end = mem.linenum;
+        LINE_LENGTH( mem.program_end ) = length;
+        mem.program_end += length;
+        last = mem.linenum;
+    }
+    fclose( f );
+    return 1;
+}
+
+
+/* output helpers ************************************************************/
+
+/* bytes as a C string literal */
+static void emit_string( const unsigned char * s, int n )
+{
+    fputc( '"', out );
+    for( int i = 0 ; i < n ; i++ ) {
+        unsigned char c = s[ i ];
+        if( c == '"' || c == '\\' || c == '?' ) {
+            fprintf( out, "\\%c", c );
+        } else if( c == CR ) {
+            fputs( "\\r", out );
+        } else if( c == NL ) {
+            fputs( "\\n", out );
+        } else if( c < ' ' || c > '~' ) {
+            fprintf( out, "\\%03o", c );
+        } else {
+            fputc( c, out );
+        }
+    }
+    fputc( '"', out );
+}
+
+/* the name of a variable, a letter or the spelling of its slot */
+static const char * name_of( unsigned char v )
+{
+    static char name[ kNameLength + 1 ];
+    int i = 0;
+
+    if( v < NAME_TOKEN ) {
+        name[ i++ ] = v;
+    } else {
+        unsigned char * spelling = mem.names + ( v - NAME_TOKEN ) * kNameLength;
+        while( i < kNameLength && spelling[ i ] != 0 ) {
+            name[ i ] = spelling[ i ];
+            i++;
+        }
+    }
+    name[ i ] = '\0';
+    return name;
+}
+
+/* the word number index of a keyword table, for the error messages */
+static const char * word_of( const unsigned char * table, unsigned char index )
+{
+    static char word[ 16 ];
+    int i = 0;
+
+    while( index-- > 0 )
+        while( !( pgm_read_byte( table++ ) & 0x80 ))
+            ;
+    do {
+        word[ i++ ] = pgm_read_byte( table ) & 0x7F;
+    } while( !( pgm_read_byte( table++ ) & 0x80 ) && i < (int)sizeof( word ) - 1 );
+    word[ i ] = '\0';
+    return word;
+}
+
+/* the label of the first line numbered n or more, like findline() */
+static const char * label_of( LINENUM n )
+{
+    static char label[ 16 ];
+    unsigned char * l;
+
+    mem.linenum = n;
+    l = mem.findline();
+    if( l == mem.program_end ) return "done";
+    snprintf( label, sizeof( label ), "L%u", *(LINENUM *)l );
+    return label;
+}
+
+static void refuse( const char * what )
+{
+    fprintf( stderr, "line %u: %s can not be translated\n", *(LINENUM *)line, what );
+    refused = 1;
+}
+
+
+/* failures ******************************************************************/
+
+static int add_failure( char * text )
+{
+    failures = (char **)realloc( failures, ( failure_count + 1 ) * sizeof( char * ));
+    failures[ failure_count ] = text;
+    return failure_count++;
+}
+
+static char * message( const unsigned char * msg )
+{
+    char * text = (char *)malloc( strlen( (const char *)msg ) + 3 );
+    sprintf( text, "%s\r\n", (const char *)msg );
+    return text;
+}
+
+/* what qwhat prints for an error at txtpos: the line, marked with a ^ */
+static char * listing( void )
+{
+    static unsigned char buffer[ 512 ];
+    unsigned char tmp = *mem.txtpos;
+    unsigned short n;
+    char * text;
+
+    if( tmp != NL ) *mem.txtpos = '^';
+    IO.memory_write( buffer, sizeof( buffer ));
+    IO.printmsgNoNL( whatmsg );
+    mem.list_line = line;
+    IO.printline();
+    IO.line_terminator();
+    n = IO.memory_written();
+    IO.outStream = streamioClass::streamType::kStreamSerial;
+    *mem.txtpos = tmp;
+
+    text = (char *)malloc( n + 1 );
+    memcpy( text, buffer, n );
+    text[ n ] = '\0';
+    return text;
+}
+
+#ifdef ENABLE_LINK
+/* what RUN prints when the link pass finds errors, NULL if it finds none */
+static char * link_report( void )
+{
+    static unsigned char buffer[ 2048 ];
+    unsigned short errors, n;
+    char * text;
+
+    mem.heap_reset();
+    IO.memory_write( buffer, sizeof( buffer ));
+    errors = linker.link();
+    n = IO.memory_written();
+    IO.outStream = streamioClass::streamType::kStreamSerial;
+    /* the jumps it linked take heap the translation does not have */
+    linker.reset();
+    mem.heap_reset();
+    if( errors == 0 ) return NULL;
+
+    text = (char *)malloc( n + 1 );
+    memcpy( text, buffer, n );
+    text[ n ] = '\0';
+    return text;
+}
+#endif
+
+/* the failure for the errors found while the expression runs */
+static int expression_failure( void )
+{
+    if( expr_fail < 0 ) expr_fail = add_failure( NULL );
+    return expr_fail;
+}
+
+/* the errors of the expression just translated show as qwhat or qhow */
+static void settle( int how )
+{
+    if( expr_fail >= 0 ) failures[ expr_fail ] = how ? message( howmsg ) : listing();
+    expr_fail = -1;
+}
+
+/* the statement stops the program here, and so do the errors of the
+ *  expression it could not finish */
+static void what( void )
+{
+    int f = add_failure( listing());
+
+    if( expr_fail >= 0 ) failures[ expr_fail ] = failures[ f ];
+    expr_fail = -1;
+    fprintf( out, "        fail( %d );\n", f );
+}
+
+static void how( void )
+{
+    settle( 1 );
+    fprintf( out, "        fail( FAIL_HOW );\n" );
+}
+
+
+/* expressions ***************************************************************/
+
+static void literal( struct operand * o, VALUE value )
+{
+    o->constant = 1;
+    o->value = value;
+    snprintf( o->text, sizeof( o->text ), value < 0 ? "(%d)" : "%d", value );
+}
+
+static void variable( struct operand * o, const char * fmt, const char * name )
+{
+    o->constant = 0;
+    snprintf( o->text, sizeof( o->text ), fmt, name );
+}
+
+/* a temporary set to the C++ expression fmt */
+static void temp( struct operand * o, const char * fmt, ... )
+{
+    va_list ap;
+
+    /* the operands may be o itself */
+    fprintf( out, "        VALUE t%d = ", ++temps );
+    va_start( ap, fmt );
+    vfprintf( out, fmt, ap );
+    va_end( ap );
+    fprintf( out, ";\n" );
+    o->constant = 0;
+    snprintf( o->text, sizeof( o->text ), "t%d", temps );
+}
+
+static void expression( struct operand * o );
+
+/* the element of the array of v, txtpos at the "(" */
+static void element( struct operand * o, unsigned char v )
+{
+    struct operand i;
+    char arr[ 32 ];
+
+    snprintf( arr, sizeof( arr ), "arr_%s", name_of( v ));
+    /* the interpreter stops at the "(" when there is no such array, and
+     *  at the ")" when the index is out of range */
+    fprintf( out, "        if( !%s.data ) fail( %d );\n", arr, add_failure( listing()));
+    mem.txtpos++;
+    expression( &i );
+    if( bad || *mem.txtpos != ')' ) {
+        bad = 1;
+        return;
+    }
+    fprintf( out, "        if( (UVALUE)%s >= %s.count ) fail( %d );\n",
+             i.text, arr, add_failure( listing()));
+    mem.txtpos++;
+    temp( o, "%s.data[ %s ]", arr, i.text );
+}
+
+static void expr4( struct operand * o )
+{
+    mem.ignore_blanks();
+
+    if( *mem.txtpos == '-' ) {
+        struct operand a;
+        mem.txtpos++;
+        expr4( &a );
+        if( bad ) return;
+        if( a.constant ) literal( o, -a.value );
+        else temp( o, "(VALUE)-(DVALUE)%s", a.text );
+        return;
+    }
+
+#ifdef ENABLE_FIXED
+    /* the C has no fixed point variables to put them in */
+    if( *mem.txtpos == '.' || ( *mem.txtpos >= '0' && *mem.txtpos <= '9' &&
+                                *mem.constant( mem.txtpos, &o->value ) == '.' )) {
+        refuse( "a fixed point number" );
+        while( *mem.txtpos == '.' || ( *mem.txtpos >= '0' && *mem.txtpos <= '9' )) mem.txtpos++;
+        literal( o, 0 );
+        return;
+    }
+#endif
+
+    if( *mem.txtpos == '0' ) {
+        mem.txtpos++;
+        literal( o, 0 );
+        return;
+    }
+
+    if( *mem.txtpos >= '1' && *mem.txtpos <= '9' ) {
+        VALUE a = 0;
+        do {
+            a = a * 10 + *mem.txtpos - '0';
+            mem.txtpos++;
+        } while( *mem.txtpos >= '0' && *mem.txtpos <= '9' );
+        literal( o, a );
+        return;
+    }
+
+    /* a variable, or an element of an array */
+    if( mem.txtpos[ 0 ] >= NAME_TOKEN ||
+        ( mem.txtpos[ 0 ] >= 'A' && mem.txtpos[ 0 ] <= 'Z' && ( mem.txtpos[ 1 ] < 'A' || mem.txtpos[ 1 ] > 'Z' ))) {
+        unsigned char v = *mem.txtpos++;
+#ifdef ENABLE_ARRAYS
+        if( *mem.txtpos == '(' ) {
+            element( o, v );
+            return;
+        }
+#endif
+        variable( o, "var_%s", name_of( v ));
+        return;
+    }
+
+    if( mem.txtpos[ 0 ] >= 'A' && mem.txtpos[ 0 ] <= 'Z' ) {
+        struct operand a;
+        unsigned char f;
+
+        mem.scantable( func_tab );
+        f = mem.table_index;
+        if( f == FUNC_UNKNOWN || *mem.txtpos != '(' ) {
+            bad = 1;
+            return;
+        }
+        mem.txtpos++;
+#ifdef ENABLE_ARRAYS
+        if( f == FUNC_ASUM || f == FUNC_AMIN || f == FUNC_AMAX ) {
+            char arr[ 32 ];
+
+            mem.ignore_blanks();
+            if( mem.isNotVariable()) {
+                bad = 1;
+                return;
+            }
+            snprintf( arr, sizeof( arr ), "arr_%s", name_of( *mem.txtpos++ ));
+            mem.ignore_blanks();
+            if( *mem.txtpos != ')' ) {
+                bad = 1;
+                return;
+            }
+            mem.txtpos++;
+            fprintf( out, "        if( !%s.data ) fail( %d );\n", arr, expression_failure());
+            temp( o, "%s( &%s )", f == FUNC_ASUM ? "asum" : f == FUNC_AMIN ? "amin" : "amax", arr );
+            return;
+        }
+#endif
+        expression( &a );
+        if( bad || *mem.txtpos != ')' ) {
+            bad = 1;
+            return;
+        }
+        mem.txtpos++;
+        switch( f ) {
+        case FUNC_ABS:
+            temp( o, "%s < 0 ? (VALUE)-(DVALUE)%s : %s", a.text, a.text, a.text );
+            return;
+        case FUNC_SGN:
+            temp( o, "%s < 0 ? -1 : %s > 0 ? 1 : 0", a.text, a.text );
+            return;
+        case FUNC_MILLIS:
+            temp( o, "millis( %s <= 0 ? 1 : %s )", a.text, a.text );
+            return;
+        case FUNC_RND:
+            temp( o, "(VALUE)( rand() %% %s )", a.text );
+            return;
+        default:
+            refuse( word_of( func_tab, f ));
+            literal( o, 0 );
+            return;
+        }
+    }
+
+    if( *mem.txtpos == '(' ) {
+        mem.txtpos++;
+        expression( o );
+        if( bad || *mem.txtpos != ')' ) {
+            bad = 1;
+            return;
+        }
+        mem.txtpos++;
+        return;
+    }
+
+    bad = 1;
+}
+
+static void expr3( struct operand * o )
+{
+    struct operand b;
+
+    expr4( o );
+    mem.ignore_blanks();
+    while( !bad ) {
+        if( *mem.txtpos == '*' ) {
+            mem.txtpos++;
+            expr4( &b );
+            if( bad ) return;
+            if( o->constant && b.constant ) literal( o, o->value * b.value );
+            else temp( o, "(VALUE)( (DVALUE)%s * %s )", o->text, b.text );
+        } else if( *mem.txtpos == '/' ) {
+            mem.txtpos++;
+            expr4( &b );
+            if( bad ) return;
+            if( b.constant && b.value == 0 ) {
+                /* fails as it is reached: its value is never used */
+                fprintf( out, "        fail( %d );\n", expression_failure());
+                literal( o, 0 );
+            } else if( o->constant && b.constant ) {
+                literal( o, b.value == -1 ? -o->value : o->value / b.value );
+            } else {
+                if( !b.constant ) fprintf( out, "        if( %s == 0 ) fail( %d );\n", b.text, expression_failure());
+                temp( o, "(VALUE)( (DVALUE)%s / %s )", o->text, b.text );
+            }
+        } else {
+            return;
+        }
+    }
+}
+
+static void expr2( struct operand * o )
+{
+    struct operand b;
+
+    if( *mem.txtpos == '-' || *mem.txtpos == '+' ) literal( o, 0 );
+    else expr3( o );
+
+    while( !bad ) {
+        if( *mem.txtpos == '-' ) {
+            mem.txtpos++;
+            expr3( &b );
+            if( bad ) return;
+            if( o->constant && b.constant ) literal( o, o->value - b.value );
+            else temp( o, "(VALUE)( (DVALUE)%s - %s )", o->text, b.text );
+        } else if( *mem.txtpos == '+' ) {
+            mem.txtpos++;
+            expr3( &b );
+            if( bad ) return;
+            if( o->constant && b.constant ) literal( o, o->value + b.value );
+            else temp( o, "(VALUE)( (DVALUE)%s + %s )", o->text, b.text );
+        } else {
+            return;
+        }
+    }
+}
+
+static void expression( struct operand * o )
+{
+    static const char * const relop[] = { ">=", "!=", ">", "==", "<=", "<", "!=" };
+    struct operand b;
+    unsigned char r;
+
+    expr2( o );
+    if( bad ) return;
+    mem.scantable( relop_tab );
+    r = mem.table_index;
+    if( r == RELOP_UNKNOWN ) return;
+    expr2( &b );
+    if( bad ) return;
+    if( o->constant && b.constant ) {
+        VALUE a = o->value;
+        switch( r ) {
+        case RELOP_GE: literal( o, a >= b.value ); break;
+        case RELOP_GT: literal( o, a > b.value ); break;
+        case RELOP_EQ: literal( o, a == b.value ); break;
+        case RELOP_LE: literal( o, a <= b.value ); break;
+        case RELOP_LT: literal( o, a < b.value ); break;
+        default: literal( o, a != b.value ); break;
+        }
+    } else {
+        temp( o, "%s %s %s", o->text, relop[ r ], b.text );
+    }
+}
+
+/* an expression of a statement */
+static int value( struct operand * o )
+{
+    bad = 0;
+    expr_fail = -1;
+    expression( o );
+    return !bad;
+}
+
+
+/* statements ****************************************************************/
+
+/* how the line goes on after a statement */
+#define GO_ON     0 /* run_next_statement */
+#define GO_DIRECT 1 /* the statement right at txtpos, after IF */
+#define GO_AWAY   2 /* the rest of the line is not run */
+
+static int end_of_statement( void )
+{
+    return *mem.txtpos == NL || *mem.txtpos == ':';
+}
+
+/* like print_quoted_string(): the closing quote of the string at txtpos,
+ *  NULL if there is none, and then an opening quote is skipped */
+static unsigned char * quoted( void )
+{
+    unsigned char delim = *mem.txtpos;
+    unsigned char * s;
+
+    if( delim != '"' && delim != '\'' ) return NULL;
+    mem.txtpos++;
+    for( s = mem.txtpos ; *s != delim ; s++ )
+        if( *s == NL ) return NULL;
+    return s;
+}
+
+static int print( void )
+{
+    struct operand e;
+
+    if( *mem.txtpos == ':' ) {
+        fprintf( out, "        newline();\n" );
+        mem.txtpos++;
+        return GO_ON;
+    }
+    if( *mem.txtpos == NL ) return GO_AWAY;
+
+    while( 1 ) {
+        unsigned char * s;
+
+        mem.ignore_blanks();
+        if(( s = quoted()) != NULL ) {
+            fprintf( out, "        fputs( " );
+            emit_string( mem.txtpos, s - mem.txtpos );
+            fprintf( out, ", stdout );\n" );
+            mem.txtpos = s + 1;
+        } else if( *mem.txtpos == '"' || *mem.txtpos == '\'' ) {
+            what();
+            return GO_AWAY;
+        } else {
+            if( !value( &e )) {
+                what();
+                return GO_AWAY;
+            }
+            settle( 0 );
+            fprintf( out, "        printnum( %s );\n", e.text );
+        }
+
+        if( *mem.txtpos == ',' ) {
+            mem.txtpos++;
+        } else if( mem.txtpos[ 0 ] == ';' && ( mem.txtpos[ 1 ] == NL || mem.txtpos[ 1 ] == ':' )) {
+            mem.txtpos++;
+            return GO_ON;
+        } else if( end_of_statement()) {
+            fprintf( out, "        newline();\n" );
+            return GO_ON;
+        } else {
+            what();
+            return GO_AWAY;
+        }
+    }
+}
+
+static int assignment( void )
+{
+    struct operand e;
+    char target[ 96 ];
+    unsigned char v;
+
+    if( mem.isNotVariable()) {
+        how();
+        return GO_AWAY;
+    }
+    v = *mem.txtpos++;
+    snprintf( target, sizeof( target ), "var_%s", name_of( v ));
+#ifdef ENABLE_ARRAYS
+    if( *mem.txtpos == '(' ) {
+        struct operand i;
+        char arr[ 32 ];
+
+        snprintf( arr, sizeof( arr ), "arr_%s", name_of( v ));
+        mem.txtpos++;
+        if( !value( &i ) || *mem.txtpos != ')' ) {
+            how();
+            return GO_AWAY;
+        }
+        settle( 1 );
+        mem.txtpos++;
+        fprintf( out, "        if( !%s.data || (UVALUE)%s >= %s.count ) fail( FAIL_HOW );\n",
+                 arr, i.text, arr );
+        snprintf( target, sizeof( target ), "%s.data[ %s ]", arr, i.text );
+    }
+#endif
+    mem.ignore_blanks();
+    if( *mem.txtpos != '=' ) {
+        what();
+        return GO_AWAY;
+    }
+    mem.txtpos++;
+    mem.ignore_blanks();
+    if( !value( &e )) {
+        what();
+        return GO_AWAY;
+    }
+    settle( 0 );
+    if( !end_of_statement()) {
+        what();
+        return GO_AWAY;
+    }
+    fprintf( out, "        %s = %s;\n", target, e.text );
+    return GO_ON;
+}
+
+/* GOTO and GOSUB: the line must end after the number */
+static int jump( int sub, const char * next )
+{
+    struct operand e;
+
+    if( !value( &e ) || *mem.txtpos != NL ) {
+        how();
+        return GO_AWAY;
+    }
+    settle( 1 );
+    if( sub ) fprintf( out, "        gosub( &&%s );\n", next );
+    if( e.constant ) {
+        fprintf( out, "        goto %s;\n", label_of( e.value ));
+    } else {
+        fprintf( out, "        target = %s;\n        goto go;\n", e.text );
+        computed_goto = 1;
+    }
+    return GO_AWAY;
+}
+
+static int forloop( const char * next )
+{
+    struct operand initial, terminal, step;
+    unsigned char v;
+
+    mem.ignore_blanks();
+    if( mem.isNotVariable()) goto what;
+    v = *mem.txtpos++;
+    mem.ignore_blanks();
+    if( *mem.txtpos != '=' ) goto what;
+    mem.txtpos++;
+    mem.ignore_blanks();
+
+    if( !value( &initial )) goto what;
+    settle( 0 );
+    mem.scantable( to_tab );
+    if( mem.table_index != 0 ) goto what;
+    if( !value( &terminal )) goto what;
+    settle( 0 );
+    mem.scantable( step_tab );
+    if( mem.table_index == 0 ) {
+        if( !value( &step )) goto what;
+        settle( 0 );
+    } else {
+        literal( &step, 1 );
+    }
+    mem.ignore_blanks();
+    if( !end_of_statement()) goto what;
+    if( *mem.txtpos != NL ) {
+        how();
+        return GO_AWAY;
+    }
+    fprintf( out, "        forpush( &var_%s, %s, %s, %s, &&%s );\n",
+             name_of( v ), initial.text, terminal.text, step.text, next );
+    return GO_AWAY;
+
+what:
+    what();
+    return GO_AWAY;
+}
+
+static int sleep_for( void )
+{
+    struct operand e;
+
+    if( !value( &e )) {
+        what();
+        return GO_AWAY;
+    }
+    settle( 0 );
+    if( e.constant && e.value < 0 ) {
+        how();
+        return GO_AWAY;
+    }
+    if( !e.constant ) fprintf( out, "        if( %s < 0 ) fail( FAIL_HOW );\n", e.text );
+    if( !end_of_statement()) {
+        what();
+        return GO_AWAY;
+    }
+    fprintf( out, "        pause( %s );\n", e.text );
+    return GO_ON;
+}
+
+#ifdef ENABLE_ARRAYS
+static int dim( void )
+{
+    struct operand n;
+    unsigned char v;
+
+    while( 1 ) {
+        mem.ignore_blanks();
+        if( mem.isNotVariable()) goto what;
+        v = *mem.txtpos++;
+        if( *mem.txtpos != '(' ) goto what;
+        mem.txtpos++;
+        if( !value( &n ) || *mem.txtpos != ')' ) goto what;
+        settle( 0 );
+        mem.txtpos++;
+        fprintf( out, "        dim( &arr_%s, %s );\n", name_of( v ), n.text );
+        mem.ignore_blanks();
+        if( *mem.txtpos != ',' ) break;
+        mem.txtpos++;
+    }
+    if( !end_of_statement()) goto what;
+    return GO_ON;
+
+what:
+    what();
+    return GO_AWAY;
+}
+
+static int bulk( unsigned char op )
+{
+    struct operand e, div;
+    char a[ 32 ], b[ 32 ];
+
+    mem.ignore_blanks();
+    if( mem.isNotVariable()) goto what;
+    snprintf( a, sizeof( a ), "arr_%s", name_of( *mem.txtpos++ ));
+    fprintf( out, "        need( &%s );\n", a );
+    mem.ignore_blanks();
+    if( *mem.txtpos != ',' ) goto what;
+    mem.txtpos++;
+    mem.ignore_blanks();
+    if( op == KW_ACOPY || op == KW_AADD ) {
+        if( mem.isNotVariable()) goto what;
+        snprintf( b, sizeof( b ), "arr_%s", name_of( *mem.txtpos++ ));
+        fprintf( out, "        need( &%s );\n", b );
+        mem.ignore_blanks();
+    } else {
+        if( !value( &e )) goto what;
+        settle( 0 );
+        literal( &div, 1 );
+        if( op == KW_ASCALE && *mem.txtpos == ',' ) {
+            mem.txtpos++;
+            if( !value( &div )) goto what;
+            settle( 0 );
+        }
+    }
+    if( !end_of_statement()) goto what;
+
+    switch( op ) {
+    case KW_AFILL:
+        fprintf( out, "        afill( &%s, %s );\n", a, e.text );
+        break;
+    case KW_ACOPY:
+        fprintf( out, "        acopy( &%s, &%s );\n", a, b );
+        break;
+    case KW_AADD:
+        fprintf( out, "        aadd( &%s, &%s );\n", a, b );
+        break;
+    default:
+        fprintf( out, "        ascale( &%s, %s, %s );\n", a, e.text, div.text );
+        break;
+    }
+    return GO_ON;
+
+what:
+    what();
+    return GO_AWAY;
+}
+#endif
+
+static int statement( const char * next )
+{
+    struct operand e;
+    unsigned char kw;
+
+    mem.scantable( keywords );
+    kw = mem.table_index;
+    switch( kw ) {
+    case KW_PRINT:
+    case KW_QMARK:
+        return print();
+    case KW_LET:
+    case KW_DEFAULT:
+        return assignment();
+    case KW_IF:
+        if( !value( &e ) || *mem.txtpos == NL ) {
+            how();
+            return GO_AWAY;
+        }
+        settle( 1 );
+        if( !e.constant ) {
+            fprintf( out, "        if( !%s ) goto %s;\n", e.text, next );
+        } else if( e.value == 0 ) {
+            fprintf( out, "        goto %s;\n", next );
+            return GO_AWAY;
+        }
+        return GO_DIRECT;
+    case KW_GOTO:
+        return jump( 0, next );
+    case KW_GOSUB:
+        return jump( 1, next );
+    case KW_RETURN:
+        fprintf( out, "        goto *ret();\n" );
+        return GO_AWAY;
+    case KW_REM:
+    case KW_QUOTE:
+        return GO_AWAY;
+    case KW_FOR:
+        return forloop( next );
+    case KW_NEXT:
+        mem.ignore_blanks();
+        if( mem.isNotVariable()) {
+            how();
+            return GO_AWAY;
+        }
+        fprintf( out, "        void * at = next( &var_%s );\n        if( at ) goto *at;\n",
+                 name_of( *mem.txtpos++ ));
+        mem.ignore_blanks();
+        if( !end_of_statement()) {
+            what();
+            return GO_AWAY;
+        }
+        return GO_ON;
+    case KW_INPUT:
+        mem.ignore_blanks();
+        if( mem.isNotVariable()) {
+            what();
+            return GO_AWAY;
+        }
+        fprintf( out, "        var_%s = input();\n", name_of( *mem.txtpos++ ));
+        mem.ignore_blanks();
+        if( !end_of_statement()) {
+            what();
+            return GO_AWAY;
+        }
+        return GO_ON;
+    case KW_POKE:
+        /* the interpreter works out both values, and leaves it there */
+        if( !value( &e )) goto what;
+        settle( 0 );
+        mem.ignore_blanks();
+        if( *mem.txtpos != ',' ) goto what;
+        mem.txtpos++;
+        mem.ignore_blanks();
+        if( !value( &e )) goto what;
+        settle( 0 );
+        if( !end_of_statement()) goto what;
+        return GO_ON;
+    case KW_END:
+    case KW_STOP:
+        if( *mem.txtpos != NL ) goto what;
+        fprintf( out, "        goto done;\n" );
+        return GO_AWAY;
+    case KW_BYE:
+        fprintf( out, "        return 0;\n" );
+        return GO_AWAY;
+    case KW_RSEED:
+        if( !value( &e )) goto what;
+        settle( 0 );
+        fprintf( out, "        srand( %s );\n", e.text );
+        return GO_ON;
+    case KW_DELAY:
+    case KW_SLEEP:
+        return sleep_for();
+#ifdef ENABLE_ARRAYS
+    case KW_DIM:
+        return dim();
+    case KW_AFILL:
+    case KW_ACOPY:
+    case KW_AADD:
+    case KW_ASCALE:
+        return bulk( kw );
+#endif
+    default:
+        refuse( word_of( keywords, kw ));
+        return GO_AWAY;
+    }
+
+what:
+    what();
+    return GO_AWAY;
+}
+
+static void translate_line( void )
+{
+    unsigned char * following = line + LINE_LENGTH( line );
+    char next[ 16 ];
+    int go = GO_DIRECT;
+
+    if( following == mem.program_end ) strcpy( next, "done" );
+    else snprintf( next, sizeof( next ), "L%u", *(LINENUM *)following );
+
+    fprintf( out, "L%u:\n", *(LINENUM *)line );
+    mem.txtpos = line + LINE_HEADER;
+    while( go != GO_AWAY ) {
+        if( go == GO_ON ) {
+            while( *mem.txtpos == ':' ) mem.txtpos++;
+            mem.ignore_blanks();
+            if( *mem.txtpos == NL ) return;
+        }
+        temps = 0;
+        fprintf( out, "    {\n" );
+        go = statement( next );
+        fprintf( out, "    }\n" );
+    }
+}
+
+
+/* the program ***************************************************************/
+
+int emit_cpp( const char * filename )
+{
+    unsigned char * l;
+    char * report = NULL;
+    int i;
+
+    if( !load( filename )) return 1;
+    out = stdout;
+    add_failure( message( howmsg ));
+    add_failure( message( sorrymsg ));
+#ifdef ENABLE_LINK
+    report = link_report();
+#endif
+
+    fprintf( out, "// %s, translated by tbp --emit-cpp\n\n", filename );
+    fprintf( out, "#define STACK_BYTES %u\n", (unsigned)STACK_SIZE );
+    fprintf( out, "#define FOR_FRAME %u\n", (unsigned)sizeof( struct stack_for_frame ));
+    fprintf( out, "#define GOSUB_FRAME %u\n", (unsigned)sizeof( struct stack_gosub_frame ));
+    fprintf( out, "#define HEAP_BYTES %lu\n", (unsigned long)mem.free_mem());
+    fprintf( out, "#define HEAP_SLACK %u\n", (unsigned)( 2 * sizeof( LINENUM ) + 2 ));
+#ifdef ENABLE_ARRAYS
+    fprintf( out, "#define ARRAY_HEADER %u\n", (unsigned)sizeof( array_header ));
+#else
+    fprintf( out, "#define ARRAY_HEADER 0\n" );
+#endif
+    fprintf( out, "typedef %s VALUE;\n", VALUE_BITS == 16 ? "short" : "int" );
+    fprintf( out, "typedef %s UVALUE;\n", VALUE_BITS == 16 ? "unsigned short" : "unsigned int" );
+    fprintf( out, "typedef long long DVALUE;\n" );
+    fputs( prelude, out );
+
+    /* the variables: A to Z, and the names the program uses */
+    fprintf( out, "\n" );
+    for( i = 0 ; i < 26 + mem.name_count ; i++ ) {
+        const char * name = name_of( i < 26 ? 'A' + i : NAME_TOKEN + i - 26 );
+        fprintf( out, "static VALUE var_%s;\nstatic struct array arr_%s;\n", name, name );
+    }
+
+    fprintf( out, "\nint main( void )\n{\n    unsigned short target;\n\n" );
+    fprintf( out, "    clock_gettime( CLOCK_MONOTONIC, &start );\n" );
+    /* RUN does not start a program the link pass finds errors in */
+    if( report ) fprintf( out, "    fail( %d );\n", add_failure( report ));
+    for( line = mem.program_start ; line < mem.program_end ; line += LINE_LENGTH( line ) )
+        translate_line();
+    fprintf( out, "done:\n    return 0;\n" );
+
+    if( computed_goto ) {
+        fprintf( out, "\ngo:\n    {\n        static const struct line lines[] = {\n" );
+        for( l = mem.program_start ; l < mem.program_end ; l += LINE_LENGTH( l ) )
+            fprintf( out, "            { %u, &&L%u },\n", *(LINENUM *)l, *(LINENUM *)l );
+        fprintf( out, "        };\n"
+                      "        unsigned lo = 0, hi = sizeof( lines ) / sizeof( lines[ 0 ] );\n"
+                      "        while( lo < hi ) {\n"
+                      "            unsigned mid = ( lo + hi ) / 2;\n"
+                      "            if( lines[ mid ].number < target ) lo = mid + 1;\n"
+                      "            else hi = mid;\n"
+                      "        }\n"
+                      "        if( lo == sizeof( lines ) / sizeof( lines[ 0 ] )) goto done;\n"
+                      "        goto *lines[ lo ].at;\n"
+                      "    }\n" );
+    }
+    fprintf( out, "}\n" );
+
+    fprintf( out, "\nconst char * const failures[] = {\n" );
+    for( i = 0 ; i < failure_count ; i++ ) {
+        fprintf( out, "    " );
+        emit_string( (const unsigned char *)failures[ i ], strlen( failures[ i ] ));
+        fprintf( out, ",\n" );
+    }
+    fprintf( out, "};\n" );
+
+    return refused;
+}
@@ -0,0 +1,10 @@
+/* --emit-cpp: translate a BASIC program into a standalone C++ program */
+
+#ifndef _EMIT_H_
+#define _EMIT_H_
+
+/* write the C++ translation of the program in filename to stdout,
+ *  0 when it worked, 1 with the reasons on stderr when it did not */
+int emit_cpp( const char * filename );
+
+#endif
@@ -1,15 +1,26 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "usermem.h"
+#include "sim.h"
+#include "emit.h"
+#include "jit.h"
+#include "replay.h"
 
 #if defined(__MINGW32__ )
 #endif
 
 #if __APPLE__ || __linux__
-#   include <dirent.h>
 #   include <sys/stat.h>
 #else
 #   error Needs fixing to compile on your system
 #endif
 
+/* -M: room for the stack and the variables, up to what the offsets reach easily */
+#define kMinMemory ( 16UL << 10 )
+#define kMaxMemory ( 1UL << 30 )
+
 /* these are used in the .ino */
 
 void outchar( char ch )
@@ -20,30 +31,95 @@ void outchar( char ch )
 
 /* other helpers */
 
-int cmd_Files( void )
-{
-    DIR * theDir;
-
-    theDir = opendir( "." );
-    if( !theDir ) return -2;
-
-    struct dirent *theDirEnt = readdir( theDir );
-    while( theDirEnt ) {
-	printf( "  %s\n", theDirEnt->d_name );
-	theDirEnt = readdir( theDir );
-    }
-    closedir( theDir );
+void setup( void );
+void loop( void );
 
-    return 0;
+/* the stack, the variables and their names take at most half the memory */
+static int memory_fits( void )
+{
+    return STACK_SIZE + VAR_COUNT * VAR_SIZE + kVarSlots * kNameLength <= mem.memory_size / 2;
 }
 
-void setup( void );
-void loop( void );
+static void usage( const char * prog )
+{
+    fprintf( stderr, "usage: %s [-s] [-l logfile] [-E eeprom] [-M size] [-S frames] [-J] [-e ms:pin:level]... [-r|-p file] [program.bas]\n", prog );
+    fprintf( stderr, "       %s [-M size] [-S frames] --emit-cpp program.bas\n", prog );
+    fprintf( stderr, "  -s          simulate: run on a virtual clock\n" );
+    fprintf( stderr, "  -l logfile  timestamped log of pin writes, tones and output\n" );
+    fprintf( stderr, "  -E eeprom   keep the EEProm contents in this file\n" );
+    fprintf( stderr, "  -M size     program memory in bytes, or with k or M (64k by default)\n" );
+    fprintf( stderr, "  -S frames   room on the stack for this many FOR or GOSUB frames\n" );
+#ifdef ENABLE_JIT
+    fprintf( stderr, "  -J          do not compile hot lines to machine code\n" );
+#endif
+    fprintf( stderr, "  -e ms:pin:level  inject an edge on an input pin at time ms\n" );
+    fprintf( stderr, "  -r file     record the input, clock, RND and pin reads of this run\n" );
+    fprintf( stderr, "  -p file     replay them from a recording, with the same options\n" );
+    fprintf( stderr, "  --emit-cpp  translate the program into C++, on stdout\n" );
+    exit( 1 );
+}
 
 int main( int argc, char ** argv )
 {
+    int i;
+
+    for( i = 1 ; i < argc ; i++ ) {
+        if( !strcmp( argv[i], "-s" )) {
+            sim_virtual_clock();
+        } else if( !strcmp( argv[i], "-l" ) && i + 1 < argc ) {
+            if( !sim_open_log( argv[++i] )) {
+                perror( argv[i] );
+                return 1;
+            }
+        } else if( !strcmp( argv[i], "-E" ) && i + 1 < argc ) {
+            if( !sim_open_eeprom( argv[++i] )) {
+                perror( argv[i] );
+                return 1;
+            }
+        } else if( !strcmp( argv[i], "-M" ) && i + 1 < argc ) {
+            char * unit;
+            mem.memory_size = strtoul( argv[++i], &unit, 10 );
+            if( *unit == 'k' || *unit == 'K' ) mem.memory_size <<= 10, unit++;
+            else if( *unit == 'm' || *unit == 'M' ) mem.memory_size <<= 20, unit++;
+            if( *unit || mem.memory_size < kMinMemory || mem.memory_size > kMaxMemory ) usage( argv[0] );
+        } else if( !strcmp( argv[i], "-S" ) && i + 1 < argc ) {
+            mem.stack_frames = atoi( argv[++i] );
+            if( mem.stack_frames < 1 || mem.stack_frames > 4096 ) usage( argv[0] );
+#ifdef ENABLE_JIT
+        } else if( !strcmp( argv[i], "-J" )) {
+            jit.enabled = false;
+#endif
+        } else if( !strcmp( argv[i], "-e" ) && i + 1 < argc ) {
+            if( !sim_add_edge( argv[++i] )) usage( argv[0] );
+        } else if( !strcmp( argv[i], "-r" ) && i + 1 < argc ) {
+            if( !replay_record( argv[++i] )) {
+                perror( argv[i] );
+                return 1;
+            }
+        } else if( !strcmp( argv[i], "-p" ) && i + 1 < argc ) {
+            if( !replay_play( argv[++i] )) {
+                fprintf( stderr, "%s: not a recording\n", argv[i] );
+                return 1;
+            }
+        } else if( !strcmp( argv[i], "--emit-cpp" ) && i + 2 == argc ) {
+            if( !memory_fits()) usage( argv[0] );
+            return emit_cpp( argv[++i] );
+        } else if( argv[i][0] != '-' && i + 1 == argc ) {
+            if( !sim_load_program( argv[i] )) {
+                perror( argv[i] );
+                return 1;
+            }
+        } else {
+            usage( argv[0] );
+        }
+    }
+
+    if( !memory_fits()) usage( argv[0] );
+
+    sim_catch_break();
     printf( "Starting up TinyBasic Plus...\n\n" );
 
     setup();
     loop();
+    sim_finish();
 }
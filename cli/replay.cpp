@@ -0,0 +1,166 @@
+/* record and replay.  Everything a run takes from outside the program
+ *  goes through sim_replay(): the clock, RND, pin reads, the console
+ *  and the break key.  Recording writes each value to the file, replay
+ *  hands back the recorded one instead of the live one.
+ *
+ *  The file is "TBPR", a version byte, then records of a tag byte and
+ *  a value in 7 bit groups, low group first, the top bit set on all but
+ *  the last.  Clock values are stored as the difference from the last
+ *  one, so most take one or two bytes. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+#include "replay.h"
+
+#define kReplayVersion 1
+
+#define REPLAY_OFF    0
+#define REPLAY_RECORD 1
+#define REPLAY_PLAY   2
+
+static int mode = REPLAY_OFF;
+static FILE * file = NULL;
+static unsigned long records = 0;
+static unsigned long last_time = 0;
+static unsigned long polls = 0;
+
+/* the next record, read ahead on replay so that replay_break can look */
+static int next_tag = EOF;
+static unsigned long next_value = 0;
+
+
+static void put_record( char tag, unsigned long v )
+{
+    putc( tag, file );
+    while( v >= 0x80 ) {
+        putc( ( v & 0x7F ) | 0x80, file );
+        v >>= 7;
+    }
+    putc( v, file );
+    records++;
+}
+
+static void read_ahead( void )
+{
+    int c, shift = 0;
+
+    next_value = 0;
+    next_tag = getc( file );
+    if( next_tag == EOF ) return;
+    do {
+        c = getc( file );
+        if( c == EOF ) {
+            next_tag = EOF;
+            return;
+        }
+        next_value |= (unsigned long)( c & 0x7F ) << shift;
+        shift += 7;
+    } while( c & 0x80 );
+}
+
+static const char * tag_name( int tag )
+{
+    switch( tag ) {
+    case 'T': return "clock";
+    case 'R': return "RND";
+    case 'P': return "pin read";
+    case 'A': return "analog read";
+    case 'I': return "console input";
+    case 'B': return "break";
+    case EOF: return "the end of the recording";
+    }
+    return "a bad record";
+}
+
+/* the run asked for something else than what was recorded: it can
+ *  not be the same run any more */
+static void diverged( int wanted )
+{
+    fflush( stdout );
+    fprintf( stderr, "replay: the run went another way after %lu records (wanted %s, found %s)\n",
+             records, tag_name( wanted ), tag_name( next_tag ));
+    exit( 1 );
+}
+
+static unsigned long take( char tag )
+{
+    unsigned long v;
+
+    if( next_tag != tag ) diverged( tag );
+    v = next_value;
+    records++;
+    read_ahead();
+    return v;
+}
+
+
+int replay_record( const char * filename )
+{
+    file = fopen( filename, "wb" );
+    if( !file ) return 0;
+    setvbuf( file, NULL, _IOFBF, 1 << 16 );
+    fputs( "TBPR", file );
+    putc( kReplayVersion, file );
+    mode = REPLAY_RECORD;
+    return 1;
+}
+
+int replay_play( const char * filename )
+{
+    char magic[ 5 ];
+
+    file = fopen( filename, "rb" );
+    if( !file ) return 0;
+    if( fread( magic, 1, 5, file ) != 5 || memcmp( magic, "TBPR", 4 ) || magic[4] != kReplayVersion ) {
+        fclose( file );
+        file = NULL;
+        return 0;
+    }
+    setvbuf( file, NULL, _IOFBF, 1 << 16 );
+    read_ahead();
+    mode = REPLAY_PLAY;
+    return 1;
+}
+
+int replay_playing( void )
+{
+    return mode == REPLAY_PLAY;
+}
+
+unsigned long sim_replay( char tag, unsigned long live )
+{
+    if( mode == REPLAY_RECORD ) {
+        if( tag == 'T' ) {
+            put_record( tag, live - last_time );
+            last_time = live;
+        } else {
+            put_record( tag, live );
+        }
+    } else if( mode == REPLAY_PLAY ) {
+        if( tag == 'T' ) {
+            last_time += take( tag );
+            return last_time;
+        }
+        return take( tag );
+    }
+    return live;
+}
+
+unsigned char replay_break( unsigned char live )
+{
+    polls++;
+    if( mode == REPLAY_RECORD && live ) {
+        put_record( 'B', polls );
+        polls = 0;
+    } else if( mode == REPLAY_PLAY ) {
+        if( next_tag != 'B' || next_value > polls ) return 0;
+        if( next_value < polls ) diverged( 'B' );
+        take( 'B' );
+        polls = 0;
+        return 1;
+    }
+    return live;
+}
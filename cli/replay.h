@@ -0,0 +1,21 @@
+/* record and replay: the inputs of a run, kept in a file so that the
+ *  run can be repeated exactly */
+
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+/* record the inputs of this run in filename */
+int replay_record( const char * filename );
+
+/* take the inputs of this run from filename, recorded by replay_record */
+int replay_play( const char * filename );
+
+/* true while the inputs come from a recording */
+int replay_playing( void );
+
+/* the break key: live is what sim_break saw.  Recorded as the number
+ *  of polls since the last break, so the polls that saw nothing cost
+ *  nothing in the file */
+unsigned char replay_break( unsigned char live );
+
+#endif
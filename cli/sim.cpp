@@ -0,0 +1,477 @@
+/* desktop simulation: virtual clock and timestamped event log
+ *
+ *  stands in for the Arduino core on the desktop: pin writes and tones
+ *  go to a mock that keeps the pin levels and counts the traffic, and
+ *  get logged along with every line of output.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "platform.h"
+#include "timer.h"
+#include "events.h"
+#include "jit.h"
+#include "fused.h"
+#include "streamio.h"
+#include "usermem.h"
+#include "sim.h"
+#include "replay.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static FILE * simlog = NULL;
+
+/* output text is logged one line at a time */
+static char outline[ 128 ];
+static int outlen = 0;
+
+void sim_virtual_clock( void )
+{
+    timers.simulated = true;
+    timers.simulated_us = 0;
+}
+
+/* the virtual clock also moves on at every read of the clock or of a
+ *  pin, by about what the statement takes on the board, so a program
+ *  polling them sees the time go by and the edges come */
+#define kSimReadUs 100
+
+void sim_tick( void )
+{
+    if( timers.simulated ) timers.simulated_us += kSimReadUs;
+}
+
+int sim_open_log( const char * filename )
+{
+    if( !strcmp( filename, "-" )) {
+        simlog = stderr;
+    } else {
+        simlog = fopen( filename, "w" );
+    }
+    return simlog != NULL;
+}
+
+/* log timestamps are in milliseconds, with microseconds */
+static void sim_stamp( const char * what )
+{
+    unsigned long us = timers.now_us();
+    fprintf( simlog, "%6lu.%03lu %-8s ", us / 1000, us % 1000, what );
+}
+
+void sim_event( const char * what, int a, int b )
+{
+    if( !simlog ) return;
+    sim_stamp( what );
+    fprintf( simlog, "%d %d\n", a, b );
+}
+
+void sim_output( unsigned char c )
+{
+    if( !simlog ) return;
+
+    if( c == '\r' ) return;
+    if( c != '\n' && outlen < (int)sizeof( outline ) - 1 ) {
+        outline[ outlen++ ] = c;
+        return;
+    }
+    outline[ outlen ] = '\0';
+    sim_stamp( "print" );
+    fprintf( simlog, "%s\n", outline );
+    outlen = 0;
+}
+
+
+/* the console.  stdin is read a byte at a time, so that sim_break can
+ *  look at what is waiting without stdio reading ahead of it: a byte it
+ *  takes that is not Ctrl-C is kept for the next sim_getchar */
+
+/* recorded as the input byte when the input ends */
+#define kInputEnd 256
+
+static volatile sig_atomic_t interrupted = 0;
+static int pending = -1;
+static int input_closed = 0;
+
+static void sim_sigint( int sig )
+{
+    (void)sig;
+    interrupted = 1;
+}
+
+void sim_catch_break( void )
+{
+    signal( SIGINT, sim_sigint );
+}
+
+unsigned char sim_break( void )
+{
+    struct pollfd p = { 0, POLLIN, 0 };
+    unsigned char c, hit = 0;
+    int r;
+
+    if( replay_playing()) {
+        if( interrupted ) {
+            fflush( stdout );
+            fprintf( stderr, "replay: interrupted\n" );
+            exit( 1 );
+        }
+        return replay_break( 0 );
+    }
+    if( interrupted ) {
+        interrupted = 0;
+        hit = 1;
+    } else {
+        if( pending < 0 && !input_closed && poll( &p, 1, 0 ) > 0 ) {
+            r = read( 0, &c, 1 );
+            if( r == 1 ) pending = c;
+            else if( r == 0 ) input_closed = 1;
+        }
+        if( pending == CTRLC ) {
+            pending = -1;
+            hit = 1;
+        }
+    }
+    return replay_break( hit );
+}
+
+/* sleeps in poll() until there is a byte.  The end of the input, or
+ *  Ctrl-C while waiting for it, ends tbp as BYE does */
+int sim_getchar( void )
+{
+    struct pollfd p = { 0, POLLIN, 0 };
+    unsigned char c;
+    int r;
+
+    if( replay_playing()) {
+        r = sim_replay( 'I', 0 );
+        if( r != kInputEnd ) return r;
+        goto done;
+    }
+    if( pending >= 0 ) {
+        c = pending;
+        pending = -1;
+        return sim_replay( 'I', c );
+    }
+    fflush( stdout );
+    while( !input_closed && !interrupted ) {
+        if( poll( &p, 1, -1 ) < 0 ) continue; /* EINTR: look at interrupted */
+        r = read( 0, &c, 1 );
+        if( r == 1 ) return sim_replay( 'I', c );
+        if( r == 0 || errno != EINTR ) input_closed = 1;
+    }
+    sim_replay( 'I', kInputEnd );
+done:
+    printf( "\n" );
+    sim_finish();
+    exit( 0 );
+}
+
+
+/* Arduino core stand-ins: a mock of the pins that records their traffic */
+
+#define kSimPins 64
+
+static struct {
+    int mode;
+    int level;
+    unsigned long writes;
+    unsigned long reads;
+    unsigned long modes;
+    void (*isr)( void );
+} simpins[ kSimPins ];
+
+
+/* edges injected on input pins, in time order */
+
+#define kSimEdges 256
+
+static struct {
+    unsigned long at;
+    int pin;
+    int level;
+} edges[ kSimEdges ];
+static int nedges = 0;
+static int nextedge = 0;
+
+int sim_add_edge( const char * spec )
+{
+    unsigned long at;
+    int pin, level, e;
+
+    if( nedges == kSimEdges ) return 0;
+    if( sscanf( spec, "%lu:%d:%d", &at, &pin, &level ) != 3 ) return 0;
+    if( pin < 0 || pin >= kSimPins ) return 0;
+
+    /* keep them sorted, the command line need not be */
+    for( e = nedges ; e > 0 && edges[ e-1 ].at > at ; e-- ) {
+        edges[ e ] = edges[ e-1 ];
+    }
+    edges[ e ].at = at;
+    edges[ e ].pin = pin;
+    edges[ e ].level = level ? HIGH : LOW;
+    nedges++;
+    return 1;
+}
+
+void sim_inject( void )
+{
+    unsigned long now = timers.now();
+
+    while( nextedge < nedges && edges[ nextedge ].at <= now ) {
+        int pin = edges[ nextedge ].pin;
+        int level = edges[ nextedge ].level;
+
+        nextedge++;
+        if( simpins[ pin ].level == level ) continue;
+        simpins[ pin ].level = level;
+        sim_event( "edge", pin, level );
+        if( simpins[ pin ].isr ) simpins[ pin ].isr();
+    }
+}
+
+unsigned long sim_next_edge( unsigned long until )
+{
+    if( nextedge < nedges && edges[ nextedge ].at < until ) {
+        return edges[ nextedge ].at;
+    }
+    return until;
+}
+
+void attachInterrupt( int irq, void (*isr)( void ), int /* mode */ )
+{
+    if( irq < 0 || irq >= kSimPins ) return;
+    simpins[ irq ].isr = isr;
+}
+
+void detachInterrupt( int irq )
+{
+    if( irq < 0 || irq >= kSimPins ) return;
+    simpins[ irq ].isr = NULL;
+}
+
+void pinMode( int pin, int mode )
+{
+    sim_event( "pinmode", pin, mode );
+    if( pin < 0 || pin >= kSimPins ) return;
+    simpins[ pin ].mode = mode;
+    simpins[ pin ].modes++;
+}
+
+void digitalWrite( int pin, int value )
+{
+    sim_event( "dwrite", pin, value );
+    if( pin < 0 || pin >= kSimPins ) return;
+    simpins[ pin ].level = value ? HIGH : LOW;
+    simpins[ pin ].writes++;
+}
+
+int digitalRead( int pin )
+{
+    sim_tick();
+    sim_inject();
+    if( pin < 0 || pin >= kSimPins ) return LOW;
+    simpins[ pin ].reads++;
+    sim_event( "dread", pin, simpins[ pin ].level );
+    return sim_replay( 'P', simpins[ pin ].level );
+}
+
+void analogWrite( int pin, int value )
+{
+    sim_event( "awrite", pin, value );
+    if( pin < 0 || pin >= kSimPins ) return;
+    simpins[ pin ].level = value;
+    simpins[ pin ].writes++;
+}
+
+/* synthetic waveforms on the analog inputs, scaled like a 10 bit ADC:
+ *  a sine on pin 0, then triangle, square and sawtooth, over and over */
+#define kSimWavePeriod 20000UL /* microseconds, 50 Hz */
+
+static int sim_wave( int pin )
+{
+    double x = (double)( timers.now_us() % kSimWavePeriod ) / kSimWavePeriod;
+
+    switch( pin % 4 ) {
+    case 0:  return 512 + (int)( 511.0 * sin( 2.0 * M_PI * x ));
+    case 1:  return (int)( 1023.0 * ( x < 0.5 ? 2.0 * x : 2.0 - 2.0 * x ));
+    case 2:  return x < 0.5 ? 1023 : 0;
+    default: return (int)( 1023.0 * x );
+    }
+}
+
+int analogRead( int pin )
+{
+    int value;
+
+    sim_tick();
+    if( pin < 0 || pin >= kSimPins ) return 0;
+    simpins[ pin ].reads++;
+    value = sim_replay( 'A', sim_wave( pin ));
+    sim_event( "aread", pin, value );
+    return value;
+}
+
+void tone( int pin, unsigned int frequency, unsigned long /* duration */ )
+{
+    sim_event( "tone", pin, frequency );
+}
+
+void noTone( int pin )
+{
+    sim_event( "notone", pin, 0 );
+}
+
+/* a program named on the command line: mapped, and typed in from there
+ * through the memory stream without a copy, then run */
+
+int sim_load_program( const char * filename )
+{
+    struct stat st;
+    void * map;
+    int fd;
+
+    fd = open( filename, O_RDONLY );
+    if( fd < 0 ) return 0;
+    if( fstat( fd, &st ) != 0 || st.st_size == 0 ) {
+        close( fd );
+        return 0;
+    }
+    if( (unsigned long)st.st_size > mem.memory_size ) {
+        errno = EFBIG; /* larger than the memory: see -M */
+        close( fd );
+        return 0;
+    }
+    map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if( map == MAP_FAILED ) return 0;
+
+    IO.memory_read( (const unsigned char *)map, st.st_size );
+    inhibitOutput = true;
+    runAfterLoad = true;
+    return 1;
+}
+
+
+/* the program memory: the whole size reserved at once, with no backing
+ *  until a page is touched, so a large -M costs only what the program uses */
+unsigned char * sim_memory( unsigned long size )
+{
+    void * map;
+
+    map = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    if( map == MAP_FAILED ) {
+        perror( "program memory" );
+        exit( 1 );
+    }
+    return (unsigned char *)map;
+}
+
+
+/* EEProm: kept in memory, and in a file if one is given.
+ *  a write takes 3.3 ms like on the AVR, which shows on the virtual clock */
+
+#define kSimEEWriteUs 3300
+
+EEPROMClass EEPROM;
+
+static unsigned char eeprom[ E2END + 1 ];
+static int eeprom_ready = 0;
+static FILE * eefile = NULL;
+static unsigned long eewrites = 0;
+
+static void sim_eeprom_init( void )
+{
+    if( eeprom_ready ) return;
+    memset( eeprom, 0xFF, sizeof( eeprom )); /* erased */
+    eeprom_ready = 1;
+}
+
+int sim_open_eeprom( const char * filename )
+{
+    sim_eeprom_init();
+    eefile = fopen( filename, "r+b" );
+    if( eefile ) {
+        if( fread( eeprom, 1, sizeof( eeprom ), eefile )) { /* a short file stays erased at the end */ }
+    } else {
+        eefile = fopen( filename, "w+b" );
+        if( !eefile ) return 0;
+        fwrite( eeprom, 1, sizeof( eeprom ), eefile );
+        fflush( eefile );
+    }
+    return 1;
+}
+
+unsigned char EEPROMClass::read( int idx )
+{
+    sim_eeprom_init();
+    return eeprom[ idx & E2END ];
+}
+
+void EEPROMClass::write( int idx, unsigned char val )
+{
+    sim_eeprom_init();
+    idx &= E2END;
+    eeprom[ idx ] = val;
+    eewrites++;
+    if( timers.simulated ) timers.simulated_us += kSimEEWriteUs;
+    if( eefile ) {
+        fseek( eefile, idx, SEEK_SET );
+        fputc( val, eefile );
+        fflush( eefile );
+    }
+}
+
+
+#ifdef ENABLE_FUSED
+static const char * fusednames[ FUSED_KINDS ] = { "V=V+k", "IF GOTO", "NEXT", "PRINT V" };
+#endif
+
+void sim_finish( void )
+{
+    int p;
+
+    if( !simlog ) return;
+    if( eewrites ) {
+        sim_stamp( "eeprom" );
+        fprintf( simlog, "%lu writes, %lu.%lu ms of EEProm write time\n",
+                 eewrites, eewrites * kSimEEWriteUs / 1000, eewrites * kSimEEWriteUs / 100 % 10 );
+    }
+    for( p = 0 ; p < kSimPins ; p++ ) {
+        if( simpins[ p ].writes || simpins[ p ].reads || simpins[ p ].modes ) {
+            sim_stamp( "traffic" );
+            fprintf( simlog, "pin %d: %lu writes, %lu reads, %lu mode switches\n",
+                     p, simpins[ p ].writes, simpins[ p ].reads, simpins[ p ].modes );
+        }
+    }
+    if( events.overruns ) {
+        sim_stamp( "overrun" );
+        fprintf( simlog, "%u events dropped, queue full\n", events.overruns );
+    }
+#ifdef ENABLE_FUSED
+    for( p = 0 ; p < FUSED_KINDS ; p++ ) {
+        if( fused.fired[ p ] ) {
+            sim_stamp( "fused" );
+            fprintf( simlog, "%s: %lu times\n", fusednames[ p ], fused.fired[ p ] );
+        }
+    }
+    if( fused.fallbacks ) {
+        sim_stamp( "fused" );
+        fprintf( simlog, "%lu fallbacks\n", fused.fallbacks );
+    }
+#endif
+#ifdef ENABLE_JIT
+    if( jit.compiled ) {
+        sim_stamp( "jit" );
+        fprintf( simlog, "%lu lines compiled\n", jit.compiled );
+    }
+#endif
+    fflush( simlog );
+}
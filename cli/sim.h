@@ -0,0 +1,30 @@
+/* desktop simulation: virtual clock and timestamped event log */
+
+#ifndef _SIM_H_
+#define _SIM_H_
+
+/* run on the virtual clock: DELAY, SLEEP, tones and timers take no real time */
+void sim_virtual_clock( void );
+
+/* write the event log to this file ("-" for stderr) */
+int sim_open_log( const char * filename );
+
+/* add an event to the log, stamped with the current (virtual) time */
+void sim_event( const char * what, int a, int b );
+
+/* Ctrl-C breaks a running program instead of ending tbp */
+void sim_catch_break( void );
+
+/* load this program and run it */
+int sim_load_program( const char * filename );
+
+/* keep the EEProm in this file */
+int sim_open_eeprom( const char * filename );
+
+/* inject an edge on an input pin: "ms:pin:level" */
+int sim_add_edge( const char * spec );
+
+/* summary of the pin traffic, at the end of the log */
+void sim_finish( void );
+
+#endif
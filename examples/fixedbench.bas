@@ -0,0 +1,9 @@
+10 REM a low pass filter on 30000 readings, in fixed point
+20 FIXED K, Y
+30 K = 0.125 : Y = 0
+40 T = MILLIS(1)
+50 FOR I = 1 TO 30000
+60 R = I / 300
+70 Y = Y + K*(R-Y)
+80 NEXT I
+90 PRINT "Y = ", Y, " in ", MILLIS(1) - T, " ms"
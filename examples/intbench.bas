@@ -0,0 +1,10 @@
+10 REM the filter of fixedbench.bas, with the values scaled by hand:
+20 REM Y is 256 times the value, and K is 1/8
+30 Y = 0
+40 T = MILLIS(1)
+50 FOR I = 1 TO 30000
+60 R = I / 300
+70 Y = Y + (R*32-Y/8)
+80 NEXT I
+90 F = (Y-Y/256*256)*1000/256
+100 PRINT "Y = ", Y / 256, ".", F, " in ", MILLIS(1) - T, " ms"
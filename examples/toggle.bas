@@ -0,0 +1,8 @@
+10 REM GPIO toggle rate benchmark: 20000 pin writes
+20 T=MILLIS(1)
+30 FOR I=1 TO 10000
+40 DWRITE 13,HIGH
+50 DWRITE 13,LOW
+60 NEXT I
+70 T=MILLIS(1)-T
+80 PRINT "20000 writes in ",T," ms"
@@ -0,0 +1,11 @@
+10 REM wrap around, division and precedence, as wide as VALUE
+20 K=32767:K=K+1:PRINT K
+30 K=2147483647:K=K+1:PRINT K
+40 K=1:N=0
+50 K=K*2:N=N+1:IF K>0 GOTO 50
+60 PRINT N," ",K
+70 B=5:C=B/-1:PRINT C," ",-7/2," ",7/-2," ",-7/-2
+80 PRINT 2+3*4," ",(2+3)*4," ",10-4-3," ",100/10/5," ",-2*-3
+90 PRINT 1<2,2<1,3=3,3<>3,4>=4,4<=3,5!=6
+100 PRINT 123*456," ",30000+30000," ",-32768-1
+110 PRINT ABS(-5)," ",SGN(-5)," ",SGN(0)," ",SGN(9)
@@ -0,0 +1,11 @@
+10 REM DIM and the bulk operations
+20 DIM A(9), B(9)
+30 FOR I=0 TO 9
+40 A(I)=I*I: NEXT I
+50 PRINT ASUM(A)," ",AMIN(A)," ",AMAX(A)
+60 AFILL B, 3
+70 AADD A, B: PRINT A(0)," ",A(9)," ",ASUM(A)
+80 ASCALE A, 3, 2: PRINT A(1)," ",A(9)
+90 ACOPY B, A: PRINT B(5)," ",ASUM(B)
+100 B(0)=-100: PRINT AMIN(B)
+110 PRINT A(10)
@@ -0,0 +1,10 @@
+10 REM READ and RESTORE; the input starts it again with GOTO
+20 READ A,B
+30 PRINT A," ",B
+40 READ C:PRINT C
+50 RESTORE 100:READ D:PRINT D
+60 RESTORE:READ E:PRINT E
+70 END
+80 DATA 1,-2
+90 DATA 3:REM "DATA 9" is not read
+100 DATA +4, 5
@@ -0,0 +1,6 @@
+10 REM times in ms past 16 bits: DELAY waits them, ON TIMER refuses them
+20 T=MILLIS(0): DELAY 70000: PRINT MILLIS(0)-T
+30 ON TIMER 70000 GOSUB 100
+40 PRINT "NOT REACHED"
+50 END
+100 RETURN
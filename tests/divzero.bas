@@ -0,0 +1,5 @@
+10 REM a division by zero in a compiled line stops the program at its line
+20 K=0:W=0
+30 K=K+1:Q=500/(K-80):W=W+Q
+40 IF K<100 GOTO 30
+50 PRINT "NOT REACHED"
@@ -0,0 +1,15 @@
+10 REM fixed point variables, printed with their decimals
+20 FIXED X, Y
+30 X = 1.25
+40 Y = X * 3
+50 PRINT X," ",Y," ",X / 2," ",.5," ",0.75 + 1
+60 A = 2.7
+70 PRINT A," ",-X," ",X - 3," ",1 / 3.0
+80 FOR X = 0 TO 1 STEP 0.25
+90 PRINT X
+100 NEXT X
+110 PRINT 10 * 1.5," ",0.001," ",0.002," ",1.996
+120 IF 0.5 PRINT "half true"
+130 Y = -2.5: PRINT Y," ",ABS(Y)," ",SGN(Y)," ",Y * Y
+140 B = 7: Y = B: PRINT Y," ",Y / B," ",B / 2.0
+150 PRINT X > 3,X < 4.5,2.5 = 2.5
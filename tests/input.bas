@@ -0,0 +1,7 @@
+10 REM an answer may use the names of the program, not new ones
+20 TOTAL=7
+30 INPUT A
+40 PRINT A
+50 INPUT B
+60 PRINT B
+70 MEM
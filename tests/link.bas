@@ -0,0 +1,7 @@
+10 REM RUN reports the bad jumps and loops, and does not start
+20 PRINT "NOT RUN"
+30 GOTO 1000
+40 FOR I=1 TO 3
+50 NEXT J
+60 IF I>1 GOSUB 2000
+70 GOTO 20+I
@@ -0,0 +1,28 @@
+10 REM FOR and GOSUB, which end their line, and the frames they keep
+20 FOR I=1 TO 3
+30 GOSUB 220
+40 NEXT I
+50 PRINT ""
+60 FOR I=10 TO 1 STEP -3
+70 PRINT I;
+80 NEXT I: PRINT ""
+90 FOR I=1 TO 3
+100 FOR J=1 TO I
+110 PRINT I*10+J;
+120 NEXT J: NEXT I: PRINT ""
+130 S=0
+140 FOR I=1 TO 2000
+150 S=S+I/7: NEXT I: PRINT S
+160 IF I>2 GOTO 180
+170 PRINT "NO"
+180 PRINT "YES": GOTO 200
+190 PRINT "SKIPPED"
+200 GOSUB 300
+210 END
+220 PRINT I;
+230 RETURN
+300 GOSUB 400
+310 PRINT "BACK"
+320 RETURN
+400 PRINT "DEEP"
+410 RETURN
@@ -0,0 +1,11 @@
+10 REM ESAVE MIN leaves out the comments and the blanks not needed
+20 GOSUB 100
+30 FOR I = 1 TO 2
+40 PRINT "A  B", I: REM the comment goes, the PRINT stays
+50 NEXT I
+60 GOTO 200
+100 REM a line GOSUB goes to stays, as a bare REM
+110 ' and one no jump goes to is left out
+120 RETURN
+200 ' so does this one
+210 END
@@ -0,0 +1,8 @@
+10 REM long names, and words that start like keywords
+20 COUNT=3: TOTAL=0: ONE=1: TOP=10
+30 FOR INDEX=1 TO COUNT
+40 TOTAL=TOTAL+INDEX*TOP: NEXT INDEX
+50 PRINT TOTAL," ",ONE," ",INDEX
+60 FORI=1TO2
+70 PRINTI:NEXTI
+80 LETTER=5: PRINT LETTER
@@ -0,0 +1,9 @@
+10 REM ON TIMER on the virtual clock
+20 N=0
+30 ON TIMER 10 GOSUB 100
+40 DELAY 55
+50 ON TIMER 0 GOSUB 100
+60 PRINT "TICKS ", N
+70 END
+100 N=N+1: PRINT "TICK ", N
+110 RETURN